@@ -66,12 +66,65 @@ namespace Silmaril {
         }
     }
 
+    void JobSystem::Execute(JobContext& context, const std::function<void()>& job)
+    {
+        context.counter.fetch_add(1);
+
+        Execute([&context, job]() {
+            job();
+            context.counter.fetch_sub(1);
+        });
+    }
+
+    void JobSystem::Dispatch(JobContext& context, u32 jobCount, u32 groupSize, const std::function<void(JobDispatchArgs)>& job)
+    {
+        if (jobCount == 0 || groupSize ==  0) return;
+
+        u32 groupCount = (jobCount - 1) / groupSize + 1;
+
+        context.counter.fetch_add(groupCount);
+
+        // Every group is queued under one lock, so no worker runs ahead on a group while the rest are still being queued
+        {
+            std::scoped_lock<std::mutex> lock(s_QueueMutex);
+            s_JobsInProgress += groupCount;
+
+            for (u32 groupIndex = 0; groupIndex < groupCount; ++groupIndex) {
+                s_JobQueue.push([&context, job, groupIndex, groupSize, jobCount]() {
+                    u32 groupJobOffset = groupIndex * groupSize;
+                    u32 groupJobEnd = std::min(groupJobOffset + groupSize, jobCount);
+
+                    JobDispatchArgs args;
+                    args.groupIndex = groupIndex;
+
+                    for (u32 i = groupJobOffset; i < groupJobEnd; ++i) {
+                        args.jobIndex = i;
+                        job(args);
+                    }
+
+                    context.counter.fetch_sub(1);
+                });
+            }
+        }
+
+        s_WakeCondition.notify_all();
+    }
+
     void JobSystem::Sync()
     {
         std::unique_lock<std::mutex> lock(s_QueueMutex);
         s_WaitCondition.wait(lock, []() { return s_JobsInProgress.load() == 0; });
     }
 
+    void JobSystem::Wait(const JobContext& context)
+    {
+        while (IsBusy(context)) {
+            if (!RunPendingJob()) {
+                std::this_thread::yield();
+            }
+        }
+    }
+
     void JobSystem::WorkerLoop()
     {
         while (true) {
@@ -92,13 +145,36 @@ namespace Silmaril {
             }
 
             if (job) {
-                job();
+                RunJob(job);
+            }
+        }
+    }
 
-                if (s_JobsInProgress.fetch_sub(1) == 1) {
-                    std::scoped_lock<std::mutex> lock(s_QueueMutex);
-                    s_WaitCondition.notify_all();
-                }
+    bool JobSystem::RunPendingJob()
+    {
+        std::function<void()> job;
+
+        {
+            std::scoped_lock<std::mutex> lock(s_QueueMutex);
+            if (s_JobQueue.empty()) {
+                return false;
             }
+
+            job = std::move(s_JobQueue.front());
+            s_JobQueue.pop();
+        }
+
+        RunJob(job);
+        return true;
+    }
+
+    void JobSystem::RunJob(const std::function<void()>& job)
+    {
+        job();
+
+        if (s_JobsInProgress.fetch_sub(1) == 1) {
+            std::scoped_lock<std::mutex> lock(s_QueueMutex);
+            s_WaitCondition.notify_all();
         }
     }
 
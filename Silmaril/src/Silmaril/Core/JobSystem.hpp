@@ -8,6 +8,11 @@ namespace Silmaril {
         u32 groupIndex;
     };
 
+    struct JobContext
+    {
+        std::atomic<u32> counter { 0 };
+    };
+
     class JobSystem
     {
     public:
@@ -17,11 +22,23 @@ namespace Silmaril {
         static void Execute(const std::function<void()>& job);
         static void Dispatch(u32 jobCount, u32 groupSize, const std::function<void(JobDispatchArgs)>& job);
 
+        static void Execute(JobContext& context, const std::function<void()>& job);
+        static void Dispatch(JobContext& context, u32 jobCount, u32 groupSize, const std::function<void(JobDispatchArgs)>& job);
+
         static void Sync();
 
+        // Blocks until every job tracked by the context has finished, running queued jobs on the calling thread meanwhile
+        static void Wait(const JobContext& context);
+
+        inline static bool IsBusy(const JobContext& context) { return context.counter.load() > 0; }
+        inline static u32 GetWorkerCount() { return static_cast<u32>(s_WorkerThreads.size()); }
+
     private:
         static void WorkerLoop();
 
+        static bool RunPendingJob();
+        static void RunJob(const std::function<void()>& job);
+
     private:
         inline static std::queue<std::function<void()>> s_JobQueue;
         inline static std::mutex s_QueueMutex;
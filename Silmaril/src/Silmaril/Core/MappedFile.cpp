@@ -0,0 +1,124 @@
+#include "MappedFile.hpp"
+
+#if defined(_WIN32)
+    #define WIN32_LEAN_AND_MEAN
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace Silmaril {
+
+    MappedFile::~MappedFile()
+    {
+        Close();
+    }
+
+    MappedFile::MappedFile(MappedFile&& other) noexcept
+    {
+        *this = std::move(other);
+    }
+
+    MappedFile& MappedFile::operator=(MappedFile&& other) noexcept
+    {
+        if (this != &other) {
+            Close();
+
+            m_Data = std::exchange(other.m_Data, nullptr);
+            m_Size = std::exchange(other.m_Size, 0);
+#if defined(_WIN32)
+            m_File = std::exchange(other.m_File, nullptr);
+            m_Mapping = std::exchange(other.m_Mapping, nullptr);
+#endif
+        }
+
+        return *this;
+    }
+
+#if defined(_WIN32)
+
+    std::optional<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+    {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return std::nullopt;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return std::nullopt;
+        }
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping) {
+            CloseHandle(file);
+            return std::nullopt;
+        }
+
+        const void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data) {
+            CloseHandle(mapping);
+            CloseHandle(file);
+            return std::nullopt;
+        }
+
+        MappedFile mapped;
+        mapped.m_Data = static_cast<const u8*>(data);
+        mapped.m_Size = static_cast<usize>(size.QuadPart);
+        mapped.m_File = file;
+        mapped.m_Mapping = mapping;
+
+        return mapped;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data) UnmapViewOfFile(m_Data);
+        if (m_Mapping) CloseHandle(m_Mapping);
+        if (m_File) CloseHandle(m_File);
+
+        m_Data = nullptr;
+        m_Size = 0;
+        m_Mapping = nullptr;
+        m_File = nullptr;
+    }
+
+#else
+
+    std::optional<MappedFile> MappedFile::Open(const std::filesystem::path& path)
+    {
+        i32 fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) return std::nullopt;
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size == 0) {
+            close(fd);
+            return std::nullopt;
+        }
+
+        void* data = mmap(nullptr, static_cast<usize>(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        // The mapping keeps the file referenced on its own
+        close(fd);
+
+        if (data == MAP_FAILED) return std::nullopt;
+
+        MappedFile mapped;
+        mapped.m_Data = static_cast<const u8*>(data);
+        mapped.m_Size = static_cast<usize>(info.st_size);
+
+        return mapped;
+    }
+
+    void MappedFile::Close()
+    {
+        if (m_Data) munmap(const_cast<u8*>(m_Data), m_Size);
+
+        m_Data = nullptr;
+        m_Size = 0;
+    }
+
+#endif
+
+}
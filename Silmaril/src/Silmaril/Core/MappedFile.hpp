@@ -0,0 +1,36 @@
+#pragma once
+
+namespace Silmaril {
+
+    // Read-only memory mapping of a whole file. Processes mapping the same file share its pages through the page cache.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+
+        static std::optional<MappedFile> Open(const std::filesystem::path& path);
+
+        inline const u8* GetData() const { return m_Data; }
+        inline usize GetSize() const { return m_Size; }
+
+    private:
+        void Close();
+
+    private:
+        const u8* m_Data { nullptr };
+        usize m_Size { 0 };
+
+#if defined(_WIN32)
+        void* m_File { nullptr };
+        void* m_Mapping { nullptr };
+#endif
+    };
+
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64)
+    #define SILMARIL_SIMD_SSE 1
+#endif
+
+#if defined(__AVX2__)
+    #define SILMARIL_SIMD_AVX2 1
+#endif
+
+#if defined(SILMARIL_SIMD_SSE) || defined(SILMARIL_SIMD_AVX2)
+    #include <immintrin.h>
+#endif
@@ -0,0 +1,70 @@
+#include "AliasTable.hpp"
+
+namespace Silmaril {
+
+    AliasTable::AliasTable(std::span<const f32> weights)
+    {
+        u32 n = static_cast<u32>(weights.size());
+        m_Bins.resize(n);
+        if (n == 0) return;
+
+        f64 sum = 0.0;
+        for (f32 weight : weights) {
+            sum += std::max(weight, 0.0f);
+        }
+
+        // Bin probabilities scaled by the bin count, 1 is a bin that fills itself exactly
+        std::vector<f64> scaled(n);
+        for (u32 i = 0; i < n; ++i) {
+            f64 pmf = sum > 0.0 ? std::max(weights[i], 0.0f) / sum : 1.0 / n;
+            m_Bins[i].pmf = static_cast<f32>(pmf);
+            scaled[i] = pmf * n;
+        }
+
+        std::vector<u32> under;
+        std::vector<u32> over;
+        for (u32 i = 0; i < n; ++i) {
+            (scaled[i] < 1.0 ? under : over).push_back(i);
+        }
+
+        // Each underfull bin is topped up from one overfull bin, which then becomes its alias
+        while (!under.empty() && !over.empty()) {
+            u32 small = under.back();
+            under.pop_back();
+            u32 large = over.back();
+            over.pop_back();
+
+            m_Bins[small].q = static_cast<f32>(scaled[small]);
+            m_Bins[small].alias = large;
+
+            scaled[large] -= 1.0 - scaled[small];
+            (scaled[large] < 1.0 ? under : over).push_back(large);
+        }
+
+        // Whatever is left is full up to rounding
+        for (u32 i : under) {
+            m_Bins[i].q = 1.0f;
+            m_Bins[i].alias = i;
+        }
+
+        for (u32 i : over) {
+            m_Bins[i].q = 1.0f;
+            m_Bins[i].alias = i;
+        }
+    }
+
+    u32 AliasTable::Sample(f32 u, f32& pmf) const
+    {
+        u32 n = GetSize();
+
+        f32 scaled = u * n;
+        u32 bin = std::min(static_cast<u32>(scaled), n - 1);
+        f32 up = std::min(scaled - bin, 0x1.fffffep-1f);
+
+        u32 index = up < m_Bins[bin].q ? bin : m_Bins[bin].alias;
+        pmf = m_Bins[index].pmf;
+
+        return index;
+    }
+
+}
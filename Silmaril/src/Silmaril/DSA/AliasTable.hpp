@@ -0,0 +1,33 @@
+#pragma once
+
+namespace Silmaril {
+
+    // Samples an index with probability proportional to its weight in constant time (Vose's alias method)
+    class AliasTable
+    {
+    public:
+        AliasTable() = default;
+        // Weights that sum to zero sample uniformly
+        AliasTable(std::span<const f32> weights);
+
+        inline u32 GetSize() const { return static_cast<u32>(m_Bins.size()); }
+        inline bool IsEmpty() const { return m_Bins.empty(); }
+
+        inline f32 PMF(u32 index) const { return m_Bins[index].pmf; }
+
+        // u in [0, 1), picks a bin with the top of u and takes the bin or its alias with the rest
+        u32 Sample(f32 u, f32& pmf) const;
+
+    private:
+        struct Bin
+        {
+            // Chance of keeping the bin over its alias
+            f32 q;
+            u32 alias;
+            f32 pmf;
+        };
+
+        std::vector<Bin> m_Bins;
+    };
+
+}
@@ -0,0 +1,91 @@
+#include "PiecewiseConstant.hpp"
+
+namespace Silmaril {
+
+    PiecewiseConstant1D::PiecewiseConstant1D(std::span<const f32> function)
+        : m_Function(function.begin(), function.end())
+    {
+        u32 n = GetSize();
+        m_CDF.resize(n + 1);
+        if (n == 0) return;
+
+        for (f32& value : m_Function) {
+            value = std::max(value, 0.0f);
+        }
+
+        f64 sum = 0.0;
+        m_CDF[0] = 0.0f;
+        for (u32 i = 0; i < n; ++i) {
+            sum += static_cast<f64>(m_Function[i]) / n;
+            m_CDF[i + 1] = static_cast<f32>(sum);
+        }
+
+        m_Integral = static_cast<f32>(sum);
+
+        for (u32 i = 1; i <= n; ++i) {
+            m_CDF[i] = sum > 0.0 ? static_cast<f32>(m_CDF[i] / sum) : static_cast<f32>(i) / n;
+        }
+        m_CDF[n] = 1.0f;
+    }
+
+    f32 PiecewiseConstant1D::Sample(f32 u, f32& pdf, u32& index) const
+    {
+        u32 n = GetSize();
+
+        // Last CDF entry at or below u, steps of zero width are never picked
+        auto it = std::upper_bound(m_CDF.begin(), m_CDF.end(), u);
+        index = std::clamp(static_cast<u32>(it - m_CDF.begin()) - 1, 0u, n - 1);
+
+        f32 du = u - m_CDF[index];
+        f32 width = m_CDF[index + 1] - m_CDF[index];
+        if (width > 0.0f) du /= width;
+
+        pdf = PDF(index);
+
+        return std::min((index + du) / n, 0x1.fffffep-1f);
+    }
+
+    PiecewiseConstant2D::PiecewiseConstant2D(std::span<const f32> function, u32 width, u32 height)
+    {
+        if (width == 0 || height == 0) return;
+
+        m_Conditional.reserve(height);
+        for (u32 y = 0; y < height; ++y) {
+            m_Conditional.emplace_back(function.subspan(static_cast<usize>(y) * width, width));
+        }
+
+        std::vector<f32> marginal(height);
+        for (u32 y = 0; y < height; ++y) {
+            marginal[y] = m_Conditional[y].GetIntegral();
+        }
+
+        m_Marginal = PiecewiseConstant1D(marginal);
+    }
+
+    glm::vec2 PiecewiseConstant2D::Sample(const glm::vec2& u, f32& pdf) const
+    {
+        f32 pdfY;
+        f32 pdfX;
+        u32 row;
+        u32 column;
+
+        f32 y = m_Marginal.Sample(u[1], pdfY, row);
+        f32 x = m_Conditional[row].Sample(u[0], pdfX, column);
+
+        pdf = pdfX * pdfY;
+
+        return glm::vec2(x, y);
+    }
+
+    f32 PiecewiseConstant2D::PDF(const glm::vec2& p) const
+    {
+        u32 height = m_Marginal.GetSize();
+        u32 width = m_Conditional[0].GetSize();
+
+        u32 row = std::min(static_cast<u32>(p.y * height), height - 1);
+        u32 column = std::min(static_cast<u32>(p.x * width), width - 1);
+
+        return m_Conditional[row].PDF(column) * m_Marginal.PDF(row);
+    }
+
+}
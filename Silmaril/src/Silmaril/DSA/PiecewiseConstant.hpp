@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Silmaril {
+
+    // Continuous density over [0, 1) proportional to a step function, sampled by inverting its CDF
+    class PiecewiseConstant1D
+    {
+    public:
+        PiecewiseConstant1D() = default;
+        // A function that is zero everywhere samples uniformly
+        PiecewiseConstant1D(std::span<const f32> function);
+
+        inline u32 GetSize() const { return static_cast<u32>(m_Function.size()); }
+        inline f32 GetIntegral() const { return m_Integral; }
+
+        inline f32 PDF(u32 index) const
+        {
+            return m_Integral > 0.0f ? m_Function[index] / m_Integral : 1.0f;
+        }
+
+        // u in [0, 1), returns a point in [0, 1) with its density and the step it falls in
+        f32 Sample(f32 u, f32& pdf, u32& index) const;
+
+    private:
+        std::vector<f32> m_Function;
+        // One entry more than the function, from 0 to 1
+        std::vector<f32> m_CDF;
+        f32 m_Integral { 0.0f };
+    };
+
+    // Density over [0, 1)^2 proportional to a grid of values, as a marginal over rows and one conditional per row
+    class PiecewiseConstant2D
+    {
+    public:
+        PiecewiseConstant2D() = default;
+        // Row-major, width values per row
+        PiecewiseConstant2D(std::span<const f32> function, u32 width, u32 height);
+
+        inline bool IsEmpty() const { return m_Conditional.empty(); }
+
+        // Returns (x, y) in [0, 1)^2 and the density there
+        glm::vec2 Sample(const glm::vec2& u, f32& pdf) const;
+
+        f32 PDF(const glm::vec2& p) const;
+
+    private:
+        std::vector<PiecewiseConstant1D> m_Conditional;
+        PiecewiseConstant1D m_Marginal;
+    };
+
+}
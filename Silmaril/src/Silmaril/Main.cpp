@@ -11,6 +11,7 @@ int main()
     constexpr u32 IMAGE_HEIGHT = 600;
     constexpr u32 SAMPLES = 32;
     constexpr u32 DEPTH = 8;
+    constexpr f32 TIME_BUDGET = 0.0f;
 
     constexpr u32 TILE_SIZE = 16;
 
@@ -35,7 +36,20 @@ int main()
             .up = { 0.0f, 1.0f, 0.0f },
             .fov = 90.0f,
 
-            .output = "Output.png"
+            .output = "Output.png",
+
+            .bvh = {
+                .bins = 16,
+                .traversalCost = 1.0f,
+                .intersectionCost = 1.0f,
+                .maxPrimitivesInLeaf = 16,
+                .triangleBatchWidth = 4,
+                .layout = Silmaril::BVH::Layout::Wide4,
+                .strategy = Silmaril::BVH::Strategy::SBVH,
+                .cache = true
+            },
+
+            .timeBudget = TIME_BUDGET
         },
 
         .renderer = {
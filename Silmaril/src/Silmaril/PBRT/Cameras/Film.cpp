@@ -28,6 +28,20 @@ namespace Silmaril {
     {
         m_Pixels.resize(width * height, glm::vec3(0.0f));
         m_Accumulator.resize(width * height, glm::vec3(0.0f));
+
+        m_SampleCounts.resize(width * height, 0);
+        m_LuminanceMean.resize(width * height, 0.0f);
+        m_LuminanceM2.resize(width * height, 0.0f);
+    }
+
+    void Film::Clear()
+    {
+        std::fill(m_Pixels.begin(), m_Pixels.end(), glm::vec3(0.0f));
+        std::fill(m_Accumulator.begin(), m_Accumulator.end(), glm::vec3(0.0f));
+
+        std::fill(m_SampleCounts.begin(), m_SampleCounts.end(), 0);
+        std::fill(m_LuminanceMean.begin(), m_LuminanceMean.end(), 0.0f);
+        std::fill(m_LuminanceM2.begin(), m_LuminanceM2.end(), 0.0f);
     }
 
     void Film::SetPixel(u32 x, u32 y, const glm::vec3& color)
@@ -42,14 +56,37 @@ namespace Silmaril {
         m_Pixels[x + y * m_Width] += L;
     }
 
-    void Film::AccumulateSample(u32 x, u32 y, const glm::vec3& L, u32 sample)
+    void Film::AccumulateSample(u32 x, u32 y, const glm::vec3& L)
     {
         if (x >= m_Width || y >= m_Height) return;
 
         usize index = x + y * m_Width;
+        u32 count = ++m_SampleCounts[index];
 
         m_Accumulator[index] += L;
-        m_Pixels[index] = m_Accumulator[index] / static_cast<f32>(sample);
+        m_Pixels[index] = m_Accumulator[index] / static_cast<f32>(count);
+
+        f32 luminance = glm::dot(L, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+        f32 delta = luminance - m_LuminanceMean[index];
+        m_LuminanceMean[index] += delta / static_cast<f32>(count);
+        m_LuminanceM2[index] += delta * (luminance - m_LuminanceMean[index]);
+    }
+
+    u64 Film::GetTotalSampleCount() const
+    {
+        return std::accumulate(m_SampleCounts.begin(), m_SampleCounts.end(), u64 { 0 });
+    }
+
+    f32 Film::GetRelativeError(u32 x, u32 y) const
+    {
+        usize index = x + y * m_Width;
+        u32 count = m_SampleCounts[index];
+        if (count < 2) return std::numeric_limits<f32>::infinity();
+
+        f32 variance = m_LuminanceM2[index] / static_cast<f32>(count - 1);
+        f32 standardError = std::sqrt(variance / static_cast<f32>(count));
+
+        return standardError / std::max(m_LuminanceMean[index], s_MinLuminance);
     }
 
     void Film::Write(const std::string& filename) const
@@ -14,9 +14,24 @@ namespace Silmaril {
         inline u32 GetHeight() const { return m_Height; }
         inline std::vector<glm::vec3> GetPixels() const { return m_Pixels; }
 
+        // Drops every accumulated sample
+        void Clear();
+
         void SetPixel(u32 x, u32 y, const glm::vec3& color);
         void AddSample(u32 x, u32 y, const glm::vec3& L);
-        void AccumulateSample(u32 x, u32 y, const glm::vec3& L, u32 sample);
+        // Adds one sample to the pixel's mean and to the running variance of its luminance
+        void AccumulateSample(u32 x, u32 y, const glm::vec3& L);
+
+        inline u32 GetSampleCount(u32 x, u32 y) const { return m_SampleCounts[x + y * m_Width]; }
+        u64 GetTotalSampleCount() const;
+
+        // Standard error of the pixel's mean luminance relative to the mean, infinite below two samples
+        f32 GetRelativeError(u32 x, u32 y) const;
+
+        inline bool IsConverged(u32 x, u32 y, f32 threshold, u32 minSamples) const
+        {
+            return GetSampleCount(x, y) >= std::max(minSamples, 2u) && GetRelativeError(x, y) < threshold;
+        }
 
         void Write(const std::string& filename) const;
 
@@ -26,6 +41,14 @@ namespace Silmaril {
 
         std::vector<glm::vec3> m_Pixels;
         std::vector<glm::vec3> m_Accumulator;
+
+        std::vector<u32> m_SampleCounts;
+        // Welford running mean and sum of squared deviations of the sample luminance
+        std::vector<f32> m_LuminanceMean;
+        std::vector<f32> m_LuminanceM2;
+
+        // Floor of the mean in the relative error, so black pixels converge instead of dividing by zero
+        inline static constexpr f32 s_MinLuminance = 1e-3f;
     };
 
 }
@@ -19,7 +19,7 @@ namespace Silmaril {
                 if (t0 < clip.max) clip.max = t0;
             }
 
-            if (clip.max <= clip.min) {
+            if (clip.max < clip.min) {
                 return false;
             }
         }
@@ -41,6 +41,48 @@ namespace Silmaril {
             return x;
         }
 
+        inline glm::vec3 Centroid() const
+        {
+            return glm::vec3(
+                (x.min + x.max) * 0.5f,
+                (y.min + y.max) * 0.5f,
+                (z.min + z.max) * 0.5f
+            );
+        }
+
+        inline f32 SurfaceArea() const
+        {
+            if (x.min > x.max || y.min > y.max || z.min > z.max) return 0.0f;
+
+            f32 dx = x.Size();
+            f32 dy = y.Size();
+            f32 dz = z.Size();
+
+            return 2.0f * (dx * dy + dy * dz + dz * dx);
+        }
+
+        // Intersection of both boxes, inverted when they are disjoint
+        inline AABB Overlap(const AABB& other) const
+        {
+            return AABB(
+                Bounds(std::max(x.min, other.x.min), std::min(x.max, other.x.max)),
+                Bounds(std::max(y.min, other.y.min), std::min(y.max, other.y.max)),
+                Bounds(std::max(z.min, other.z.min), std::min(z.max, other.z.max))
+            );
+        }
+
+        inline bool IsEmpty() const
+        {
+            return x.min > x.max || y.min > y.max || z.min > z.max;
+        }
+
+        inline u32 MaxExtentAxis() const
+        {
+            if (x.Size() > y.Size() && x.Size() > z.Size()) return 0;
+            if (y.Size() > z.Size()) return 1;
+            return 2;
+        }
+
         bool Hit(const Ray& ray, Bounds clip) const;
     };
 
@@ -0,0 +1,43 @@
+#include "DirectionCone.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+namespace Silmaril {
+
+    namespace {
+
+        f32 SafeAcos(f32 x)
+        {
+            return std::acos(std::clamp(x, -1.0f, 1.0f));
+        }
+
+    }
+
+    DirectionCone DirectionCone::Union(const DirectionCone& a, const DirectionCone& b)
+    {
+        if (a.IsEmpty()) return b;
+        if (b.IsEmpty()) return a;
+
+        f32 thetaA = SafeAcos(a.cosTheta);
+        f32 thetaB = SafeAcos(b.cosTheta);
+        f32 thetaD = SafeAcos(glm::dot(a.w, b.w));
+
+        // One cone already contains the other
+        if (std::min(thetaD + thetaB, glm::pi<f32>()) <= thetaA) return a;
+        if (std::min(thetaD + thetaA, glm::pi<f32>()) <= thetaB) return b;
+
+        f32 thetaO = (thetaA + thetaD + thetaB) * 0.5f;
+        if (thetaO >= glm::pi<f32>()) return EntireSphere();
+
+        glm::vec3 axis = glm::cross(a.w, b.w);
+        if (glm::dot(axis, axis) == 0.0f) return EntireSphere();
+        axis = glm::normalize(axis);
+
+        // Rotates a.w toward b.w until the new cone's edge meets the far edge of a
+        f32 thetaR = thetaO - thetaA;
+        glm::vec3 w = a.w * std::cos(thetaR) + glm::cross(axis, a.w) * std::sin(thetaR) + axis * glm::dot(axis, a.w) * (1.0f - std::cos(thetaR));
+
+        return DirectionCone(w, std::cos(thetaO));
+    }
+
+}
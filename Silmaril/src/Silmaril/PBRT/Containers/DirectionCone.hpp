@@ -0,0 +1,33 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace Silmaril {
+
+    // Directions within acos(cosTheta) of the axis w, empty when cosTheta is +infinity
+    struct DirectionCone
+    {
+        glm::vec3 w { 0.0f, 0.0f, 1.0f };
+        f32 cosTheta { std::numeric_limits<f32>::infinity() };
+
+        DirectionCone() = default;
+
+        DirectionCone(const glm::vec3& w, f32 cosTheta)
+            : w(glm::normalize(w)), cosTheta(cosTheta)
+        {
+        }
+
+        explicit DirectionCone(const glm::vec3& w)
+            : DirectionCone(w, 1.0f)
+        {
+        }
+
+        inline static DirectionCone EntireSphere() { return DirectionCone(glm::vec3(0.0f, 0.0f, 1.0f), -1.0f); }
+
+        inline bool IsEmpty() const { return cosTheta == std::numeric_limits<f32>::infinity(); }
+
+        // Smallest cone holding both cones
+        static DirectionCone Union(const DirectionCone& a, const DirectionCone& b);
+    };
+
+}
@@ -9,11 +9,19 @@ namespace Silmaril {
 
     class Shape;
     class Primitive;
+    class Material;
+    class Light;
 
     struct HitInteraction
     {
         f32 t { std::numeric_limits<f32>::max() };
         const Primitive* primitive { nullptr };
+        // Primitive hit in object space when primitive is an instance
+        const Primitive* objectPrimitive { nullptr };
+        // Element hit inside primitive when it stores elements without objects, e.g. a triangle reference of a mesh BVH
+        u32 primitiveIndex { 0 };
+        // Parametric coordinates from the intersection kernel, the weights (b1, b2) of the second and third vertex for triangles
+        glm::vec2 barycentrics { 0.0f };
     };
 
     struct Interaction
@@ -83,6 +91,12 @@ namespace Silmaril {
         const Shape* shape { nullptr };
         const Primitive* primitive { nullptr };
 
+        // Resolved per hit, a single primitive can carry a material per triangle
+        const Material* material { nullptr };
+        const Light* light { nullptr };
+        // Triangle hit within its mesh, lights spread over a mesh find the emitter by it
+        u32 triangle { 0 };
+
         std::shared_ptr<BSDF> bsdf { nullptr };
 
         f32 t { 0.0f };
@@ -1,143 +1,420 @@
 #include "BVH.hpp"
+#include "BVHBuilder.hpp"
+#include "BVHCache.hpp"
+#include "TriangleMesh.hpp"
 
 #include "Silmaril/Core/Logger.hpp"
+#include "Silmaril/Core/JobSystem.hpp"
+
+#include "Silmaril/DSA/PCG32.hpp"
 
 namespace Silmaril {
 
     namespace {
 
-        struct BVHBuildNode
+        // Every visited wide node pushes at most N - 1 entries on top of the one it replaced, and a path
+        // through the collapsed tree visits at most one wide node per binary level
+        constexpr u32 s_WideStackSize = BVH::s_MaxDepth * (8 - 1) + 1;
+
+        // Compressed leaf slots store their primitive count in a byte
+        constexpr u32 s_MaxCompressedLeafPrimitives = 255;
+
+        // Subtrees at least this large refit their first child as a job
+        constexpr u32 s_ParallelRefitThreshold = 8192;
+
+        // Rays traced through both node formats for the build log comparison
+        constexpr u32 s_BenchmarkRayCount = 16384;
+
+        const char* LayoutName(BVH::Layout layout)
         {
-            AABB bounds;
-            BVHBuildNode* children[2];
-            u32 splitAxis;
-            u32 firstPrimOffset;
-            u32 nPrimitives;
+            switch (layout) {
+                case BVH::Layout::Wide4: return "BVH4";
+                case BVH::Layout::Wide8: return "BVH8";
+                case BVH::Layout::Compressed4: return "Compressed BVH4";
+                case BVH::Layout::Compressed8: return "Compressed BVH8";
+                default: return "Binary";
+            }
+        }
 
-            void InitLeaf(u32 first, u32 n, const AABB& b)
-            {
-                firstPrimOffset = first;
-                nPrimitives = n;
-                bounds = b;
-                children[0] = nullptr;
-                children[1] = nullptr;
+        const char* StrategyName(BVH::Strategy strategy)
+        {
+            switch (strategy) {
+                case BVH::Strategy::SBVH: return "SBVH";
+                case BVH::Strategy::LBVH: return "LBVH";
+                default: return "SAH";
             }
+        }
+
+        template <u32 N>
+        f32 AverageChildren(const std::vector<WideBVHNode<N>>& nodes)
+        {
+            if (nodes.empty()) return 0.0f;
 
-            void InitInterior(u32 axis, BVHBuildNode* c0, BVHBuildNode* c1)
-            {
-                children[0] = c0;
-                children[1] = c1;
-                bounds = AABB(c0->bounds, c1->bounds);
-                splitAxis = axis;
-                nPrimitives = 0;
+            u32 children = 0;
+            for (const WideBVHNode<N>& node : nodes) {
+                for (u32 i = 0; i < N; ++i) {
+                    if (node.minX[i] <= node.maxX[i]) children++;
+                }
             }
+
+            return static_cast<f32>(children) / nodes.size();
+        }
+
+        std::vector<Ray> GenerateBenchmarkRays(const AABB& bounds)
+        {
+            PCG32 rng;
+            rng.Seed(0x853c49e6748fea9bULL, 0xda3e39cb94b95bdbULL);
+
+            std::vector<Ray> rays(s_BenchmarkRayCount);
+            for (Ray& ray : rays) {
+                glm::vec3 origin(
+                    bounds.x.min + rng.Float32() * bounds.x.Size(),
+                    bounds.y.min + rng.Float32() * bounds.y.Size(),
+                    bounds.z.min + rng.Float32() * bounds.z.Size()
+                );
+
+                glm::vec3 direction;
+                do {
+                    direction = glm::vec3(rng.Float32(), rng.Float32(), rng.Float32()) * 2.0f - 1.0f;
+                } while (glm::dot(direction, direction) > 1.0f || glm::dot(direction, direction) < 1e-4f);
+
+                ray = Ray(origin, glm::normalize(direction));
+            }
+
+            return rays;
+        }
+
+        // Packet widths there is a leaf kernel for, anything else falls back to one triangle at a time
+        u32 TriangleBatchWidth(u32 width)
+        {
+            return width >= 8 ? 8 : (width >= 4 ? 4 : 1);
+        }
+
+        using BoundFn = std::function<AABB(u32)>;
+
+        struct BVHHierarchy
+        {
+            // Spatial splits can reference a primitive more than once
+            std::vector<u32> primitiveIndices;
+            std::vector<LinearBVHNode> nodes;
+            f32 sahCost;
         };
 
-        glm::vec3 GetCentroid(const AABB& bbox)
+        template <typename T>
+        std::vector<T> Gather(const std::vector<T>& items, const std::vector<u32>& indices)
         {
-            return glm::vec3(
-                (bbox.x.min + bbox.x.max) * 0.5f,
-                (bbox.y.min + bbox.y.max) * 0.5f,
-                (bbox.z.min + bbox.z.max) * 0.5f
-            );
+            std::vector<T> gathered(indices.size());
+
+            JobContext context;
+            JobSystem::Dispatch(context, static_cast<u32>(indices.size()), 4096, [&](JobDispatchArgs args) {
+                gathered[args.jobIndex] = items[indices[args.jobIndex]];
+            });
+            JobSystem::Wait(context);
+
+            return gathered;
         }
 
-        BVHBuildNode* BuildBVHRecursive(
-            std::vector<std::shared_ptr<Primitive>>& primitives,
-            u32 start, u32 end,
-            u32& totalNodes,
-            u32& totalLeaves,
-            u32 depth, u32& maxDepth
-        )
+        BVHBuildResult BuildNodes(const BVHBuilder::ClipBoundFn& clipBound, const std::vector<AABB>& primitiveBounds, const BVH::Config& config)
         {
-            maxDepth = std::max(maxDepth, depth);
-            BVHBuildNode* node = new BVHBuildNode();
-            totalNodes++;
+            switch (config.strategy) {
+                case BVH::Strategy::SBVH: return BVHBuilder::BuildSBVH(primitiveBounds, clipBound, config);
+                case BVH::Strategy::LBVH: return BVHBuilder::BuildLBVH(primitiveBounds, config);
+                default: return BVHBuilder::BuildSAH(primitiveBounds, config);
+            }
+        }
 
-            AABB centroidBounds;
-            AABB bbox;
-            for (u32 i = start; i < end; ++i) {
-                AABB pb = primitives[i]->GetBound();
-                glm::vec3 c = GetCentroid(pb);
-                centroidBounds = AABB(centroidBounds, AABB(c, c));
-                bbox = AABB(bbox, pb);
+        BVHHierarchy BuildHierarchy(u32 nPrimitives, const BoundFn& bound, const BVHBuilder::ClipBoundFn& clipBound, const BVHCache::PositionsFn& positions, const BVH::Config& config, bool useCache)
+        {
+            BVH::Config buildConfig = config;
+            if (config.layout == BVH::Layout::Compressed4 || config.layout == BVH::Layout::Compressed8) {
+                // Leaves are padded to whole batches afterwards and must still fit the count byte
+                u32 width = std::max(config.triangleBatchWidth, 1u);
+                buildConfig.maxPrimitivesInLeaf = std::min(config.maxPrimitivesInLeaf, s_MaxCompressedLeafPrimitives / width * width);
             }
 
-            u32 nPrimitives = end - start;
-            if (nPrimitives == 1) {
-                node->InitLeaf(start, nPrimitives, bbox);
-                totalLeaves++;
-                return node;
+            std::vector<AABB> primitiveBounds(nPrimitives);
+            JobContext context;
+            JobSystem::Dispatch(context, nPrimitives, 4096, [&](JobDispatchArgs args) {
+                primitiveBounds[args.jobIndex] = bound(args.jobIndex);
+            });
+            JobSystem::Wait(context);
+
+            BVHBuildResult build;
+            if (useCache && config.cache && BVHCache::IsCacheable(buildConfig, positions)) {
+                auto cacheStart = std::chrono::steady_clock::now();
+                u64 key = BVHCache::ComputeKey(primitiveBounds, positions, buildConfig);
+
+                if (auto cached = BVHCache::Load(key, nPrimitives)) {
+                    build = std::move(*cached);
+
+                    std::chrono::duration<f64, std::milli> timeCache = std::chrono::steady_clock::now() - cacheStart;
+                    LOG_INFO("BVH loaded from cache {} in {:.2f} ms", BVHCache::GetPath(key).string(), timeCache.count());
+                } else {
+                    build = BuildNodes(clipBound, primitiveBounds, buildConfig);
+                    if (BVHCache::Store(key, nPrimitives, build)) {
+                        LOG_INFO("BVH stored to cache {}", BVHCache::GetPath(key).string());
+                    }
+                }
+            } else {
+                build = BuildNodes(clipBound, primitiveBounds, buildConfig);
             }
 
-            AABB nodeBounds = bbox;
+            u32 nReferences = static_cast<u32>(build.primitiveIndices.size());
 
-            i32 axis = 0;
-            f32 maxExtent = centroidBounds.x.Size();
-            if (centroidBounds.y.Size() > maxExtent) {
-                axis = 1;
-                maxExtent = centroidBounds.y.Size();
+            BVHMetrics metrics = BVHBuilder::ComputeMetrics(build.nodes, buildConfig);
+            assert(metrics.maxDepth <= BVH::s_MaxDepth);
+
+            LOG_INFO("BVH Construction Metrics");
+            LOG_INFO(" - Strategy: {}", StrategyName(config.strategy));
+            if (config.strategy == BVH::Strategy::LBVH) {
+                LOG_INFO(" - Morton Codes: {} bits{}", config.mortonBits <= 30 ? 30 : 63, config.optimizeTreelets ? ", treelet optimization" : "");
             }
-            if (centroidBounds.z.Size() > maxExtent) {
-                axis = 2;
+            LOG_INFO(" - Total Primitives: {}", nPrimitives);
+            if (config.strategy == BVH::Strategy::SBVH) {
+                LOG_INFO(" - Primitive References: {} ({:.2f}x, {} spatial splits)", nReferences, static_cast<f32>(nReferences) / nPrimitives, build.spatialSplits);
             }
+            LOG_INFO(" - Internal Nodes: {}", metrics.totalNodes);
+            LOG_INFO(" - Leaf Nodes: {}", metrics.totalLeaves);
+            LOG_INFO(" - Max Tree Depth: {}", metrics.maxDepth);
+            LOG_INFO(" - SAH Cost: {:.4f} ({} bins, Ct {:.2f}, Ci {:.2f})", metrics.sahCost, config.bins, config.traversalCost, config.intersectionCost);
+            LOG_INFO(" - Build Threads: {}", JobSystem::GetWorkerCount() + 1);
 
-            u32 mid = (start + end) / 2;
-            std::nth_element(primitives.begin() + start, primitives.begin() + mid, primitives.begin() + end,
-                [axis](const std::shared_ptr<Primitive>& a, const std::shared_ptr<Primitive>& b) -> bool {
-                    glm::vec3 ca = GetCentroid(a->GetBound());
-                    glm::vec3 cb = GetCentroid(b->GetBound());
-                    return ca[axis] < cb[axis];
-                }
-            );
+            return { std::move(build.primitiveIndices), std::move(build.nodes), metrics.sahCost };
+        }
 
-            node->InitInterior(axis,
-                BuildBVHRecursive(primitives, start, mid, totalNodes, totalLeaves, depth + 1, maxDepth),
-                BuildBVHRecursive(primitives, mid, end, totalNodes, totalLeaves, depth + 1, maxDepth)
-            );
+        // Rounds every leaf up to whole batches with padding references, so each leaf starts on a packet boundary
+        void PadLeaves(std::vector<TriangleRef>& triangles, std::vector<LinearBVHNode>& nodes, u32 width)
+        {
+            if (width <= 1) return;
+
+            std::vector<TriangleRef> padded;
+            padded.reserve(triangles.size() + triangles.size() / 2);
 
-            return node;
+            for (LinearBVHNode& node : nodes) {
+                if (node.nPrimitives == 0) continue;
+
+                u32 offset = static_cast<u32>(padded.size());
+                u32 count = (node.nPrimitives + width - 1) / width * width;
+
+                padded.insert(padded.end(), triangles.begin() + node.primitivesOffset, triangles.begin() + node.primitivesOffset + node.nPrimitives);
+                padded.resize(offset + count, { TriangleRef::s_PaddingMesh, 0 });
+
+                node.primitivesOffset = offset;
+                node.nPrimitives = static_cast<u16>(count);
+            }
+
+            triangles = std::move(padded);
         }
 
-        u32 FlattenBVHTree(BVHBuildNode* node, std::vector<LinearBVHNode>& nodes)
+        // Returns the unnormalized SAH cost of the refitted subtree [index, end)
+        template <typename ReferenceBoundFn>
+        f32 RefitNodes(std::vector<LinearBVHNode>& nodes, const ReferenceBoundFn& bound, const BVH::Config& config, u32 index, u32 end)
         {
-            u32 offset = static_cast<u32>(nodes.size());
-            nodes.push_back({});
-            LinearBVHNode& linearNode = nodes[offset];
+            LinearBVHNode& node = nodes[index];
+
+            if (node.nPrimitives > 0) {
+                AABB bounds;
+                for (u32 i = 0; i < node.nPrimitives; ++i) {
+                    bounds = AABB(bounds, bound(node.primitivesOffset + i));
+                }
+                node.bounds = bounds;
 
-            linearNode.bounds = node->bounds;
-            linearNode.nPrimitives = static_cast<u16>(node->nPrimitives);
-            linearNode.pad = 0;
+                return config.intersectionCost * BVHBuilder::LeafTests(config, node.nPrimitives) * bounds.SurfaceArea();
+            }
 
-            if (node->nPrimitives > 0) {
-                linearNode.primitivesOffset = node->firstPrimOffset;
-                linearNode.axis = 0;
+            u32 second = node.secondChildOffset;
+            f32 costs[2];
+
+            if (end - index >= s_ParallelRefitThreshold) {
+                JobContext context;
+                JobSystem::Execute(context, [&]() {
+                    costs[0] = RefitNodes(nodes, bound, config, index + 1, second);
+                });
+                costs[1] = RefitNodes(nodes, bound, config, second, end);
+                JobSystem::Wait(context);
             } else {
-                linearNode.axis = static_cast<u8>(node->splitAxis);
-                FlattenBVHTree(node->children[0], nodes);
-                linearNode.secondChildOffset = FlattenBVHTree(node->children[1], nodes);
+                costs[0] = RefitNodes(nodes, bound, config, index + 1, second);
+                costs[1] = RefitNodes(nodes, bound, config, second, end);
             }
 
-            return offset;
+            node.bounds = AABB(nodes[index + 1].bounds, nodes[second].bounds);
+
+            return config.traversalCost * node.bounds.SurfaceArea() + costs[0] + costs[1];
         }
 
-        void DeleteBVHBuildNode(BVHBuildNode* node)
-        {
-            if (node) {
-                if (node->children[0]) DeleteBVHBuildNode(node->children[0]);
-                if (node->children[1]) DeleteBVHBuildNode(node->children[1]);
-                delete node;
-            }
+    }
+
+    BVH::BVH(std::vector<std::shared_ptr<Primitive>>&& primitives, std::vector<LinearBVHNode>&& nodes, const Config& config)
+        : m_Primitives(std::move(primitives)), m_Nodes(std::move(nodes)), m_Config(config), m_Layout(config.layout)
+    {
+        m_Config.triangleBatchWidth = 1;
+        BuildLayout();
+    }
+
+    BVH::BVH(std::vector<std::shared_ptr<TriangleMesh>>&& meshes, std::vector<TriangleRef>&& triangles, std::vector<LinearBVHNode>&& nodes, const Config& config)
+        : m_Meshes(std::move(meshes)), m_Triangles(std::move(triangles)), m_Nodes(std::move(nodes)), m_Config(config), m_Layout(config.layout)
+    {
+        m_Config.triangleBatchWidth = TriangleBatchWidth(config.triangleBatchWidth);
+        BuildLayout();
+    }
+
+    AABB BVH::GetReferenceBound(u32 reference) const
+    {
+        if (!m_Triangles.empty()) {
+            const TriangleRef& ref = m_Triangles[reference];
+            return ref.IsPadding() ? AABB() : m_Meshes[ref.mesh]->GetBound(ref.triangle);
+        }
+
+        return m_Primitives[reference]->GetBound();
+    }
+
+    void BVH::BuildLayout()
+    {
+        switch (m_Layout) {
+            case Layout::Wide4: m_Nodes4 = WideBVH::Collapse<4>(m_Nodes); break;
+            case Layout::Wide8: m_Nodes8 = WideBVH::Collapse<8>(m_Nodes); break;
+            case Layout::Compressed4: m_CompressedNodes4 = Compress<4>(); break;
+            case Layout::Compressed8: m_CompressedNodes8 = Compress<8>(); break;
+            default: break;
+        }
+
+        BuildPackets();
+    }
+
+    void BVH::BuildPackets()
+    {
+        m_Packets4.clear();
+        m_Packets8.clear();
+
+        if (m_Triangles.empty() || m_Config.triangleBatchWidth <= 1) return;
+
+        auto fill = [this]<u32 N>(std::vector<TrianglePacket<N>>& packets) {
+            packets.resize(m_Triangles.size() / N);
+
+            JobContext context;
+            JobSystem::Dispatch(context, static_cast<u32>(packets.size()), 1024, [&](JobDispatchArgs args) {
+                TrianglePacket<N>& packet = packets[args.jobIndex];
+                packet = TrianglePacket<N>();
+
+                for (u32 lane = 0; lane < N; ++lane) {
+                    const TriangleRef& ref = m_Triangles[args.jobIndex * N + lane];
+                    if (ref.IsPadding()) continue;
+
+                    TrianglePositions p = m_Meshes[ref.mesh]->GetPositions(ref.triangle);
+                    packet.SetTriangle(lane, p[0], p[1], p[2]);
+                }
+            });
+            JobSystem::Wait(context);
+        };
+
+        if (m_Config.triangleBatchWidth == 8) {
+            fill(m_Packets8);
+        } else {
+            fill(m_Packets4);
         }
-    
     }
 
-    BVH::BVH(std::vector<std::shared_ptr<Primitive>>&& primitives, std::vector<LinearBVHNode>&& nodes)
-        : m_Primitives(std::move(primitives)), m_Nodes(std::move(nodes))
+    template <u32 N>
+    std::vector<CompressedBVHNode<N>> BVH::Compress()
     {
+        CompressedBVHResult<N> result = CompressedBVH::Compress<N>(m_Nodes);
+
+        // Leaves were regrouped per wide node, the binary nodes now reference the same order
+        if (!m_Triangles.empty()) {
+            m_Triangles = Gather(m_Triangles, result.primitiveIndices);
+        } else {
+            m_Primitives = Gather(m_Primitives, result.primitiveIndices);
+        }
+
+        return std::move(result.nodes);
     }
 
     bool BVH::Intersect(const Ray& ray, HitInteraction& hit) const
+    {
+        switch (m_Layout) {
+            case Layout::Wide4: return IntersectWide<false>(m_Nodes4, ray, hit);
+            case Layout::Wide8: return IntersectWide<false>(m_Nodes8, ray, hit);
+            case Layout::Compressed4: return IntersectCompressed<false>(m_CompressedNodes4, ray, hit);
+            case Layout::Compressed8: return IntersectCompressed<false>(m_CompressedNodes8, ray, hit);
+            default: return IntersectBinary<false>(ray, hit);
+        }
+    }
+
+    bool BVH::IntersectP(const Ray& ray, f32 tMax) const
+    {
+        HitInteraction hit;
+        hit.t = tMax;
+
+        switch (m_Layout) {
+            case Layout::Wide4: return IntersectWide<true>(m_Nodes4, ray, hit);
+            case Layout::Wide8: return IntersectWide<true>(m_Nodes8, ray, hit);
+            case Layout::Compressed4: return IntersectCompressed<true>(m_CompressedNodes4, ray, hit);
+            case Layout::Compressed8: return IntersectCompressed<true>(m_CompressedNodes8, ray, hit);
+            default: return IntersectBinary<true>(ray, hit);
+        }
+    }
+
+    template <bool AnyHit>
+    inline bool BVH::IntersectLeaf(const Ray& ray, u32 offset, u32 count, HitInteraction& hit) const
+    {
+        bool hitAnything = false;
+
+        if (!m_Triangles.empty()) {
+            switch (m_Config.triangleBatchWidth) {
+                case 4: return IntersectPackets<AnyHit>(m_Packets4, ray, offset, count, hit);
+                case 8: return IntersectPackets<AnyHit>(m_Packets8, ray, offset, count, hit);
+                default: break;
+            }
+
+            for (u32 i = offset; i < offset + count; ++i) {
+                const TriangleRef& ref = m_Triangles[i];
+
+                if (m_Meshes[ref.mesh]->Intersect(ray, ref.triangle, hit)) {
+                    if constexpr (AnyHit) return true;
+
+                    hit.primitive = this;
+                    hit.primitiveIndex = i;
+                    hitAnything = true;
+                }
+            }
+
+            return hitAnything;
+        }
+
+        for (u32 i = offset; i < offset + count; ++i) {
+            if constexpr (AnyHit) {
+                if (m_Primitives[i]->IntersectP(ray, hit.t)) return true;
+            } else if (m_Primitives[i]->Intersect(ray, hit)) {
+                hitAnything = true;
+            }
+        }
+
+        return hitAnything;
+    }
+
+    template <bool AnyHit, u32 N>
+    inline bool BVH::IntersectPackets(const std::vector<TrianglePacket<N>>& packets, const Ray& ray, u32 offset, u32 count, HitInteraction& hit) const
+    {
+        bool hitAnything = false;
+
+        for (u32 packet = offset / N; packet < (offset + count) / N; ++packet) {
+            TrianglePacketHit packetHit;
+            if (!TrianglePacketTest::IntersectNearest<N>(packets[packet], ray, hit.t, packetHit)) continue;
+
+            if constexpr (AnyHit) return true;
+
+            hit.t = packetHit.t;
+            hit.primitive = this;
+            hit.primitiveIndex = packet * N + packetHit.lane;
+            hit.barycentrics = glm::vec2(packetHit.b1, packetHit.b2);
+            hitAnything = true;
+        }
+
+        return hitAnything;
+    }
+
+    template <bool AnyHit>
+    bool BVH::IntersectBinary(const Ray& ray, HitInteraction& hit) const
     {
         if (m_Nodes.empty()) return false;
 
@@ -148,21 +425,21 @@ namespace Silmaril {
 
         u32 toVisitOffset = 0;
         u32 currentNodeIndex = 0;
-        u32 nodesToVisit[64];
+        u32 nodesToVisit[s_MaxDepth];
 
         while (true) {
             const LinearBVHNode& node = m_Nodes[currentNodeIndex];
 
             if (node.bounds.Hit(ray, Bounds(0.0001f, hit.t))) {
                 if (node.nPrimitives > 0) {
-                    for (u32 i = 0; i < node.nPrimitives; ++i) {
-                        if (m_Primitives[node.primitivesOffset + i]->Intersect(ray, hit)) {
-                            hitAnything = true;
-                        }
+                    if (IntersectLeaf<AnyHit>(ray, node.primitivesOffset, node.nPrimitives, hit)) {
+                        if constexpr (AnyHit) return true;
+                        hitAnything = true;
                     }
                     if (toVisitOffset == 0) break;
                     currentNodeIndex = nodesToVisit[--toVisitOffset];
                 } else {
+                    assert(toVisitOffset < s_MaxDepth);
                     if (dirIsNeg[node.axis]) {
                         nodesToVisit[toVisitOffset++] = currentNodeIndex + 1;
                         currentNodeIndex = node.secondChildOffset;
@@ -180,34 +457,361 @@ namespace Silmaril {
         return hitAnything;
     }
 
+    template <bool AnyHit, u32 N>
+    bool BVH::IntersectWide(const std::vector<WideBVHNode<N>>& nodes, const Ray& ray, HitInteraction& hit) const
+    {
+        if (nodes.empty()) return false;
+
+        struct StackEntry
+        {
+            u32 index;
+            u32 nPrimitives;
+            f32 tNear;
+        };
+
+        bool hitAnything = false;
+
+        WideBVHRay wideRay(ray);
+
+        StackEntry stack[s_WideStackSize];
+        u32 stackSize = 0;
+        stack[stackSize++] = { 0, 0, 0.0f };
+
+        while (stackSize > 0) {
+            const StackEntry entry = stack[--stackSize];
+
+            // A closer hit may have been found since this entry was pushed
+            if (entry.tNear > hit.t) continue;
+
+            if (entry.nPrimitives > 0) {
+                if (IntersectLeaf<AnyHit>(ray, entry.index, entry.nPrimitives, hit)) {
+                    if constexpr (AnyHit) return true;
+                    hitAnything = true;
+                }
+                continue;
+            }
+
+            const WideBVHNode<N>& node = nodes[entry.index];
+
+            alignas(32) f32 tNear[N];
+            u32 mask = WideBVH::IntersectChildren<N>(node, wideRay, 0.0001f, hit.t, tNear);
+
+            // Sort hit slots far to near so the nearest child is popped first, any order finds an occluder
+            u32 order[N];
+            u32 hitCount = 0;
+            while (mask) {
+                u32 slot = static_cast<u32>(std::countr_zero(mask));
+                mask &= mask - 1;
+
+                if constexpr (AnyHit) {
+                    order[hitCount++] = slot;
+                    continue;
+                }
+
+                u32 j = hitCount++;
+                while (j > 0 && tNear[order[j - 1]] < tNear[slot]) {
+                    order[j] = order[j - 1];
+                    --j;
+                }
+                order[j] = slot;
+            }
+
+            assert(stackSize + hitCount <= s_WideStackSize);
+            for (u32 i = 0; i < hitCount; ++i) {
+                u32 slot = order[i];
+                stack[stackSize++] = { node.children[slot], node.nPrimitives[slot], tNear[slot] };
+            }
+        }
+
+        return hitAnything;
+    }
+
+    template <bool AnyHit, u32 N>
+    bool BVH::IntersectCompressed(const std::vector<CompressedBVHNode<N>>& nodes, const Ray& ray, HitInteraction& hit) const
+    {
+        if (nodes.empty()) return false;
+
+        struct StackEntry
+        {
+            u32 index;
+            u32 nPrimitives;
+            f32 tNear;
+        };
+
+        bool hitAnything = false;
+
+        WideBVHRay wideRay(ray);
+
+        StackEntry stack[s_WideStackSize];
+        u32 stackSize = 0;
+        stack[stackSize++] = { 0, 0, 0.0f };
+
+        while (stackSize > 0) {
+            const StackEntry entry = stack[--stackSize];
+
+            if (entry.tNear > hit.t) continue;
+
+            if (entry.nPrimitives > 0) {
+                if (IntersectLeaf<AnyHit>(ray, entry.index, entry.nPrimitives, hit)) {
+                    if constexpr (AnyHit) return true;
+                    hitAnything = true;
+                }
+                continue;
+            }
+
+            const CompressedBVHNode<N>& node = nodes[entry.index];
+
+            alignas(32) f32 tNear[N];
+            u32 mask = CompressedBVH::IntersectChildren<N>(node, wideRay, 0.0001f, hit.t, tNear);
+
+            u32 order[N];
+            u32 hitCount = 0;
+            while (mask) {
+                u32 slot = static_cast<u32>(std::countr_zero(mask));
+                mask &= mask - 1;
+
+                // Empty slots are neither interior nor hold primitives
+                if (!(node.interiorMask & (1u << slot)) && node.nPrimitives[slot] == 0) continue;
+
+                if constexpr (AnyHit) {
+                    order[hitCount++] = slot;
+                    continue;
+                }
+
+                u32 j = hitCount++;
+                while (j > 0 && tNear[order[j - 1]] < tNear[slot]) {
+                    order[j] = order[j - 1];
+                    --j;
+                }
+                order[j] = slot;
+            }
+
+            assert(stackSize + hitCount <= s_WideStackSize);
+            for (u32 i = 0; i < hitCount; ++i) {
+                u32 slot = order[i];
+                u32 below = (1u << slot) - 1;
+
+                if (node.interiorMask & (1u << slot)) {
+                    u32 child = node.childBase + static_cast<u32>(std::popcount(node.interiorMask & below));
+                    stack[stackSize++] = { child, 0, tNear[slot] };
+                } else {
+                    u32 offset = node.primitiveBase;
+                    for (u32 s = 0; s < slot; ++s) {
+                        offset += node.nPrimitives[s];
+                    }
+                    stack[stackSize++] = { offset, node.nPrimitives[slot], tNear[slot] };
+                }
+            }
+        }
+
+        return hitAnything;
+    }
+
+    template <u32 N>
+    void BVH::LogCompressionMetrics(const std::vector<CompressedBVHNode<N>>& nodes) const
+    {
+        // Same tree in the uncompressed format, only built for the comparison
+        std::vector<WideBVHNode<N>> wideNodes = WideBVH::Collapse<N>(m_Nodes);
+
+        f64 compressedBytes = static_cast<f64>(nodes.size() * sizeof(CompressedBVHNode<N>));
+        f64 wideBytes = static_cast<f64>(wideNodes.size() * sizeof(WideBVHNode<N>));
+        f64 binaryBytes = static_cast<f64>(m_Nodes.size() * sizeof(LinearBVHNode));
+
+        LOG_INFO(" - Wide Nodes: {} ({} bytes compressed, {} bytes uncompressed)", nodes.size(), sizeof(CompressedBVHNode<N>), sizeof(WideBVHNode<N>));
+        LOG_INFO(" - Node Memory: {:.2f} MB (uncompressed {:.2f} MB, {:.2f}x; binary {:.2f} MB)",
+            compressedBytes / (1024.0 * 1024.0), wideBytes / (1024.0 * 1024.0), wideBytes / compressedBytes, binaryBytes / (1024.0 * 1024.0));
+
+        std::vector<Ray> rays = GenerateBenchmarkRays(GetBound());
+
+        auto measure = [&](auto&& intersect) {
+            auto start = std::chrono::high_resolution_clock::now();
+            for (const Ray& ray : rays) {
+                HitInteraction hit;
+                intersect(ray, hit);
+            }
+            std::chrono::duration<f64> elapsed = std::chrono::high_resolution_clock::now() - start;
+            return static_cast<f64>(rays.size()) / std::max(elapsed.count(), 1e-9) * 1e-6;
+        };
+
+        f64 wideRate = measure([&](const Ray& ray, HitInteraction& hit) { return IntersectWide<false>(wideNodes, ray, hit); });
+        f64 compressedRate = measure([&](const Ray& ray, HitInteraction& hit) { return IntersectCompressed<false>(nodes, ray, hit); });
+
+        LOG_INFO(" - Throughput: {:.2f} Mrays/s compressed, {:.2f} Mrays/s uncompressed ({} rays)", compressedRate, wideRate, rays.size());
+    }
+
     void BVH::FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const
     {
+        if (!m_Triangles.empty()) {
+            const TriangleRef& ref = m_Triangles[hit.primitiveIndex];
+            m_Meshes[ref.mesh]->FillSurfaceInteraction(ray, ref.triangle, hit, intersection);
+            intersection.primitive = this;
+            return;
+        }
+
         LOG_ERROR("FillInteraction called on BVH node. This should not happen if HitRecord points to leaf primitives.");
     }
 
-    std::shared_ptr<Primitive> BVH::Create(std::vector<std::shared_ptr<Primitive>>&& primitives)
+    bool BVH::Refit()
+    {
+        if (m_Nodes.empty()) return false;
+
+        auto refitStart = std::chrono::steady_clock::now();
+
+        f32 rootCost = RefitNodes(m_Nodes, [this](u32 reference) { return GetReferenceBound(reference); }, m_Config, 0, static_cast<u32>(m_Nodes.size()));
+        f32 rootArea = m_Nodes[0].bounds.SurfaceArea();
+        f32 sahCost = rootArea > 0.0f ? rootCost / rootArea : 0.0f;
+
+        bool rebuild = m_Config.rebuildThreshold > 0.0f && sahCost > m_SAHCost * m_Config.rebuildThreshold;
+        if (rebuild) {
+            LOG_INFO("BVH SAH cost degraded from {:.4f} to {:.4f}, rebuilding", m_SAHCost, sahCost);
+            Rebuild();
+        } else {
+            BuildLayout();
+        }
+
+        std::chrono::duration<f64, std::milli> refitTime = std::chrono::steady_clock::now() - refitStart;
+        if (rebuild) {
+            LOG_INFO("BVH rebuilt in {:.2f} ms", refitTime.count());
+        } else {
+            LOG_INFO("BVH refit in {:.2f} ms (SAH cost {:.4f}, {:.2f}x of build)", refitTime.count(), sahCost, sahCost / std::max(m_SAHCost, 1e-6f));
+        }
+
+        return rebuild;
+    }
+
+    void BVH::Rebuild()
+    {
+        // Spatial splits reference some primitives from several leaves.
+        // Rebuilds follow deformation, the result is not worth keeping on disk.
+        if (!m_Triangles.empty()) {
+            std::vector<TriangleRef> triangles = m_Triangles;
+            std::erase_if(triangles, [](const TriangleRef& ref) { return ref.IsPadding(); });
+            if (m_Config.strategy == Strategy::SBVH) {
+                auto key = [](const TriangleRef& ref) { return (static_cast<u64>(ref.mesh) << 32) | ref.triangle; };
+                std::sort(triangles.begin(), triangles.end(), [&](const TriangleRef& a, const TriangleRef& b) { return key(a) < key(b); });
+                triangles.erase(std::unique(triangles.begin(), triangles.end(), [&](const TriangleRef& a, const TriangleRef& b) { return key(a) == key(b); }), triangles.end());
+            }
+
+            BVHHierarchy hierarchy = BuildHierarchy(
+                static_cast<u32>(triangles.size()),
+                [&](u32 index) { return m_Meshes[triangles[index].mesh]->GetBound(triangles[index].triangle); },
+                [&](u32 index, const AABB& clip) { return m_Meshes[triangles[index].mesh]->GetClippedBound(triangles[index].triangle, clip); },
+                nullptr, m_Config, false
+            );
+            m_Triangles = Gather(triangles, hierarchy.primitiveIndices);
+            m_Nodes = std::move(hierarchy.nodes);
+            m_SAHCost = hierarchy.sahCost;
+            PadLeaves(m_Triangles, m_Nodes, m_Config.triangleBatchWidth);
+        } else {
+            std::vector<std::shared_ptr<Primitive>> primitives = m_Primitives;
+            if (m_Config.strategy == Strategy::SBVH) {
+                std::sort(primitives.begin(), primitives.end());
+                primitives.erase(std::unique(primitives.begin(), primitives.end()), primitives.end());
+            }
+
+            BVHHierarchy hierarchy = BuildHierarchy(
+                static_cast<u32>(primitives.size()),
+                [&](u32 index) { return primitives[index]->GetBound(); },
+                [&](u32 index, const AABB& clip) { return primitives[index]->GetClippedBound(clip); },
+                nullptr, m_Config, false
+            );
+            m_Primitives = Gather(primitives, hierarchy.primitiveIndices);
+            m_Nodes = std::move(hierarchy.nodes);
+            m_SAHCost = hierarchy.sahCost;
+        }
+
+        BuildLayout();
+    }
+
+    void BVH::LogLayout() const
+    {
+        LOG_INFO(" - Layout: {}", LayoutName(m_Layout));
+        if (m_Layout == Layout::Wide4) {
+            LOG_INFO(" - Wide Nodes: {} ({:.2f} children per node)", m_Nodes4.size(), AverageChildren(m_Nodes4));
+        } else if (m_Layout == Layout::Wide8) {
+            LOG_INFO(" - Wide Nodes: {} ({:.2f} children per node)", m_Nodes8.size(), AverageChildren(m_Nodes8));
+        } else if (m_Layout == Layout::Compressed4) {
+            LogCompressionMetrics(m_CompressedNodes4);
+        } else if (m_Layout == Layout::Compressed8) {
+            LogCompressionMetrics(m_CompressedNodes8);
+        }
+    }
+
+    std::shared_ptr<Primitive> BVH::Create(std::vector<std::shared_ptr<Primitive>>&& primitives, const Config& config)
     {
         if (primitives.empty()) return nullptr;
 
-        u32 maxDepth = 0;
-        u32 totalNodes = 0;
-        u32 totalLeaves = 0;
+        // Only triangle leaves are batched
+        Config primitiveConfig = config;
+        primitiveConfig.triangleBatchWidth = 1;
 
-        BVHBuildNode* root = BuildBVHRecursive(primitives, 0, static_cast<u32>(primitives.size()), totalNodes, totalLeaves, 0, maxDepth);
+        BVHHierarchy hierarchy = BuildHierarchy(
+            static_cast<u32>(primitives.size()),
+            [&](u32 index) { return primitives[index]->GetBound(); },
+            [&](u32 index, const AABB& clip) { return primitives[index]->GetClippedBound(clip); },
+            nullptr, primitiveConfig, true
+        );
 
-        std::vector<LinearBVHNode> linearNodes;
-        linearNodes.reserve(totalNodes);
-        FlattenBVHTree(root, linearNodes);
+        auto bvh = std::make_shared<BVH>(Gather(primitives, hierarchy.primitiveIndices), std::move(hierarchy.nodes), primitiveConfig);
+        bvh->m_SAHCost = hierarchy.sahCost;
+        bvh->LogLayout();
 
-        DeleteBVHBuildNode(root);
+        return bvh;
+    }
+
+    std::shared_ptr<Primitive> BVH::Create(std::vector<std::shared_ptr<TriangleMesh>>&& meshes, const Config& config)
+    {
+        std::vector<TriangleRef> triangles;
+        for (u32 mesh = 0; mesh < meshes.size(); ++mesh) {
+            if (!meshes[mesh]) continue;
+
+            u32 nTriangles = meshes[mesh]->GetTriangleCount();
+            for (u32 triangle = 0; triangle < nTriangles; ++triangle) {
+                triangles.push_back({ mesh, triangle });
+            }
+        }
+
+        if (triangles.empty()) return nullptr;
+
+        Config triangleConfig = config;
+        triangleConfig.triangleBatchWidth = TriangleBatchWidth(config.triangleBatchWidth);
 
-        LOG_INFO("BVH Construction Metrics");
-        LOG_INFO(" - Total Primitives: {}", primitives.size());
-        LOG_INFO(" - Internal Nodes: {}", totalNodes);
-        LOG_INFO(" - Leaf Nodes: {}", totalLeaves);
-        LOG_INFO(" - Max Tree Depth: {}", maxDepth);
+        BVHHierarchy hierarchy = BuildHierarchy(
+            static_cast<u32>(triangles.size()),
+            [&](u32 index) { return meshes[triangles[index].mesh]->GetBound(triangles[index].triangle); },
+            [&](u32 index, const AABB& clip) { return meshes[triangles[index].mesh]->GetClippedBound(triangles[index].triangle, clip); },
+            [&](u32 index) { return meshes[triangles[index].mesh]->GetPositions(triangles[index].triangle); },
+            triangleConfig, true
+        );
+
+        triangles = Gather(triangles, hierarchy.primitiveIndices);
+        PadLeaves(triangles, hierarchy.nodes, triangleConfig.triangleBatchWidth);
+
+        auto bvh = std::make_shared<BVH>(std::move(meshes), std::move(triangles), std::move(hierarchy.nodes), triangleConfig);
+        bvh->m_SAHCost = hierarchy.sahCost;
+
+        f64 referenceBytes = static_cast<f64>(bvh->m_Triangles.size() * sizeof(TriangleRef));
+        f64 meshBytes = 0.0;
+        f64 meshTriangles = 0.0;
+        for (const auto& mesh : bvh->m_Meshes) {
+            meshBytes += static_cast<f64>(mesh->GetTriangleBytes() * mesh->GetTriangleCount());
+            meshTriangles += static_cast<f64>(mesh->GetTriangleCount());
+        }
+        LOG_INFO(" - Triangle Storage: {:.2f} MB references, {} + {:.1f} bytes per triangle (references, mesh indices and material)",
+            referenceBytes / (1024.0 * 1024.0), sizeof(TriangleRef), meshBytes / std::max(meshTriangles, 1.0));
+
+        if (triangleConfig.triangleBatchWidth > 1) {
+            u32 width = triangleConfig.triangleBatchWidth;
+            usize packets = bvh->m_Triangles.size() / width;
+            usize packetBytes = width == 8 ? sizeof(TrianglePacket8) : sizeof(TrianglePacket4);
+            usize padding = std::count_if(bvh->m_Triangles.begin(), bvh->m_Triangles.end(), [](const TriangleRef& ref) { return ref.IsPadding(); });
+
+            LOG_INFO(" - Triangle Packets: {} x{} ({:.2f} MB, {:.1f}% padding lanes)",
+                packets, width, static_cast<f64>(packets * packetBytes) / (1024.0 * 1024.0), 100.0 * padding / std::max<usize>(bvh->m_Triangles.size(), 1));
+        }
+        bvh->LogLayout();
 
-        return std::make_shared<BVH>(std::move(primitives), std::move(linearNodes));
+        return bvh;
     }
 
 }
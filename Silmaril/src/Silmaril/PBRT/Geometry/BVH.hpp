@@ -1,9 +1,26 @@
 #pragma once
 
 #include "Primitive.hpp"
+#include "WideBVH.hpp"
+#include "CompressedBVH.hpp"
+#include "TrianglePacket.hpp"
 
 namespace Silmaril {
 
+    class TriangleMesh;
+
+    // Triangle of one of the meshes a triangle BVH was built over
+    struct TriangleRef
+    {
+        u32 mesh;
+        u32 triangle;
+
+        // Fills batched leaves up to the batch width, never intersected
+        inline static constexpr u32 s_PaddingMesh = std::numeric_limits<u32>::max();
+
+        inline bool IsPadding() const { return mesh == s_PaddingMesh; }
+    };
+
     struct LinearBVHNode
     {
         AABB bounds;
@@ -18,9 +35,60 @@ namespace Silmaril {
 
     class BVH final : public Primitive
     {
+    public:
+        enum class Layout : u8
+        {
+            Binary,
+            Wide4,
+            Wide8,
+            Compressed4,
+            Compressed8
+        };
+
+        enum class Strategy : u8
+        {
+            SAH,
+            SBVH,
+            LBVH
+        };
+
+        struct Config
+        {
+            u32 bins { 16 };
+            f32 traversalCost { 1.0f };
+            f32 intersectionCost { 1.0f };
+            u32 maxPrimitivesInLeaf { 16 };
+            // Triangle BVHs: leaves are packed into SIMD batches of this many triangles (1, 4 or 8) and the SAH counts whole batches
+            u32 triangleBatchWidth { 1 };
+            Layout layout { Layout::Binary };
+
+            Strategy strategy { Strategy::SAH };
+
+            // SBVH: spatial splits are tried once object split children overlap by this fraction of the root area
+            f32 spatialSplitOverlap { 1e-5f };
+            // SBVH: extra primitive references allowed, as a fraction of the primitive count
+            f32 maxDuplication { 0.3f };
+
+            // LBVH: 30-bit codes fit most scenes, 63 bits keeps large scenes with fine detail apart
+            u32 mortonBits { 30 };
+            // LBVH: re-optimize the topology of small treelets after the linear build
+            bool optimizeTreelets { false };
+
+            // Refit: rebuild once the SAH cost exceeds this multiple of the cost at build time, 0 disables
+            f32 rebuildThreshold { 1.5f };
+
+            // Load the hierarchy from the on-disk cache when one was stored for the same primitives and settings,
+            // SBVH hierarchies are only cached for triangle meshes
+            bool cache { false };
+        };
+
+        // Deepest leaf any builder produces, the traversal stacks hold this many levels
+        inline static constexpr u32 s_MaxDepth = 64;
+
     public:
         BVH(const std::shared_ptr<Primitive>& left, const std::shared_ptr<Primitive>& right);
-        BVH(std::vector<std::shared_ptr<Primitive>>&& primitives, std::vector<LinearBVHNode>&& nodes);
+        BVH(std::vector<std::shared_ptr<Primitive>>&& primitives, std::vector<LinearBVHNode>&& nodes, const Config& config);
+        BVH(std::vector<std::shared_ptr<TriangleMesh>>&& meshes, std::vector<TriangleRef>&& triangles, std::vector<LinearBVHNode>&& nodes, const Config& config);
         virtual ~BVH() = default;
 
         inline virtual AABB GetBound() const override { return m_Nodes.empty() ? AABB() : m_Nodes[0].bounds; }
@@ -29,12 +97,70 @@ namespace Silmaril {
 
         virtual bool Intersect(const Ray& ray, HitInteraction& hit) const override;
         virtual void FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const override;
+        virtual bool IntersectP(const Ray& ray, f32 tMax) const override;
+
+        // Recomputes bounds bottom-up after primitives moved, keeping the topology. Rebuilds when the
+        // SAH cost degraded past Config::rebuildThreshold and returns true in that case.
+        // Must not run while the BVH is being traversed.
+        bool Refit();
+
+        static std::shared_ptr<Primitive> Create(std::vector<std::shared_ptr<Primitive>>&& primitives, const Config& config);
+
+        // BVH directly over the triangles of the meshes, leaves hold (mesh, triangle) references instead of primitives
+        static std::shared_ptr<Primitive> Create(std::vector<std::shared_ptr<TriangleMesh>>&& meshes, const Config& config);
+
+    private:
+        void BuildLayout();
+        void Rebuild();
+        void LogLayout() const;
+
+        AABB GetReferenceBound(u32 reference) const;
+
+        void BuildPackets();
+
+        template <bool AnyHit>
+        bool IntersectLeaf(const Ray& ray, u32 offset, u32 count, HitInteraction& hit) const;
 
-        static std::shared_ptr<Primitive> Create(std::vector<std::shared_ptr<Primitive>>&& primitives);
+        // Batched triangle leaves start and end on a packet boundary
+        template <bool AnyHit, u32 N>
+        bool IntersectPackets(const std::vector<TrianglePacket<N>>& packets, const Ray& ray, u32 offset, u32 count, HitInteraction& hit) const;
+
+        // AnyHit traversals stop at the first primitive closer than hit.t and leave hit untouched
+        template <bool AnyHit>
+        bool IntersectBinary(const Ray& ray, HitInteraction& hit) const;
+
+        template <bool AnyHit, u32 N>
+        bool IntersectWide(const std::vector<WideBVHNode<N>>& nodes, const Ray& ray, HitInteraction& hit) const;
+
+        template <u32 N>
+        std::vector<CompressedBVHNode<N>> Compress();
+
+        template <bool AnyHit, u32 N>
+        bool IntersectCompressed(const std::vector<CompressedBVHNode<N>>& nodes, const Ray& ray, HitInteraction& hit) const;
+
+        template <u32 N>
+        void LogCompressionMetrics(const std::vector<CompressedBVHNode<N>>& nodes) const;
 
     private:
+        // Leaves index either the primitives or, for a triangle BVH, the triangle references
         std::vector<std::shared_ptr<Primitive>> m_Primitives;
+        std::vector<std::shared_ptr<TriangleMesh>> m_Meshes;
+        std::vector<TriangleRef> m_Triangles;
+
+        // Precomputed edges of the triangle references, lane i of packet k is reference k * N + i
+        std::vector<TrianglePacket4> m_Packets4;
+        std::vector<TrianglePacket8> m_Packets8;
+
         std::vector<LinearBVHNode> m_Nodes;
+
+        Config m_Config;
+        f32 m_SAHCost { 0.0f };
+
+        Layout m_Layout { Layout::Binary };
+        std::vector<BVH4Node> m_Nodes4;
+        std::vector<BVH8Node> m_Nodes8;
+        std::vector<CompressedBVH4Node> m_CompressedNodes4;
+        std::vector<CompressedBVH8Node> m_CompressedNodes8;
     };
 
 }
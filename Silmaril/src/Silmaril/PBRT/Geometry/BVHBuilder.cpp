@@ -0,0 +1,1355 @@
+#include "BVHBuilder.hpp"
+
+#include "Silmaril/Core/JobSystem.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        constexpr u32 s_MaxBins = 64;
+
+        // Ranges at least this large spawn their left subtree as a job
+        constexpr u32 s_ParallelBuildThreshold = 4096;
+
+        // Ranges at least this large compute bounds and bins with a parallel reduction
+        constexpr u32 s_ParallelBinThreshold = 65536;
+        constexpr u32 s_ParallelChunkSize = 16384;
+
+        constexpr u32 s_ParallelFlattenThreshold = 8192;
+
+        constexpr u32 s_RadixBits = 8;
+        constexpr u32 s_RadixBuckets = 1u << s_RadixBits;
+
+        // Treelets are grown to this many leaves before their topology is re-optimized
+        constexpr u32 s_TreeletLeaves = 7;
+
+        // Past this depth the builders split at the median, halving a range of at most 2^32 primitives
+        // keeps every leaf within BVH::s_MaxDepth for the fixed traversal stacks
+        constexpr u32 s_MaxCostDepth = BVH::s_MaxDepth / 2;
+
+        struct BVHBuildNode
+        {
+            AABB bounds;
+            BVHBuildNode* children[2];
+            u32 splitAxis;
+            u32 firstPrimOffset;
+            u32 nPrimitives;
+            u32 subtreeSize;
+
+            void InitLeaf(u32 first, u32 n, const AABB& b)
+            {
+                firstPrimOffset = first;
+                nPrimitives = n;
+                bounds = b;
+                children[0] = nullptr;
+                children[1] = nullptr;
+                subtreeSize = 1;
+            }
+
+            void InitInterior(u32 axis, BVHBuildNode* c0, BVHBuildNode* c1)
+            {
+                children[0] = c0;
+                children[1] = c1;
+                bounds = AABB(c0->bounds, c1->bounds);
+                splitAxis = axis;
+                nPrimitives = 0;
+                subtreeSize = 1 + c0->subtreeSize + c1->subtreeSize;
+            }
+        };
+
+        struct BVHPrimitiveInfo
+        {
+            u32 index;
+            AABB bounds;
+            glm::vec3 centroid;
+        };
+
+        struct BVHBin
+        {
+            u32 count { 0 };
+            AABB bounds;
+        };
+
+        using BVHBins = std::array<BVHBin, s_MaxBins>;
+
+        struct BinSplit
+        {
+            f32 cost { std::numeric_limits<f32>::infinity() };
+            u32 index { 0 };
+            AABB below;
+            AABB above;
+            u32 countBelow { 0 };
+            u32 countAbove { 0 };
+        };
+
+        struct RangeBounds
+        {
+            AABB bounds;
+            AABB centroidBounds;
+        };
+
+        struct SAHBuildState
+        {
+            std::vector<BVHPrimitiveInfo>& primitiveInfo;
+            const BVH::Config& config;
+
+            // A binary tree with non-empty leaves has at most 2n - 1 nodes, so the arena never grows
+            std::vector<BVHBuildNode> arena;
+            std::atomic<u32> nodeCount { 0 };
+
+            SAHBuildState(std::vector<BVHPrimitiveInfo>& info, const BVH::Config& config)
+                : primitiveInfo(info), config(config), arena(2 * info.size() - 1)
+            {
+            }
+
+            BVHBuildNode* AllocateNode()
+            {
+                return &arena[nodeCount.fetch_add(1)];
+            }
+        };
+
+        RangeBounds ComputeRangeBounds(const SAHBuildState& state, u32 start, u32 end)
+        {
+            auto Reduce = [&](u32 first, u32 last) -> RangeBounds {
+                RangeBounds rb;
+                for (u32 i = first; i < last; ++i) {
+                    const BVHPrimitiveInfo& info = state.primitiveInfo[i];
+                    rb.centroidBounds = AABB(rb.centroidBounds, AABB(info.centroid, info.centroid));
+                    rb.bounds = AABB(rb.bounds, info.bounds);
+                }
+                return rb;
+            };
+
+            u32 n = end - start;
+            if (n < s_ParallelBinThreshold) {
+                return Reduce(start, end);
+            }
+
+            u32 chunks = (n + s_ParallelChunkSize - 1) / s_ParallelChunkSize;
+            std::vector<RangeBounds> partial(chunks);
+
+            JobContext context;
+            JobSystem::Dispatch(context, chunks, 1, [&](JobDispatchArgs args) {
+                u32 first = start + args.jobIndex * s_ParallelChunkSize;
+                u32 last = std::min(first + s_ParallelChunkSize, end);
+                partial[args.jobIndex] = Reduce(first, last);
+            });
+            JobSystem::Wait(context);
+
+            RangeBounds rb;
+            for (const RangeBounds& p : partial) {
+                rb.bounds = AABB(rb.bounds, p.bounds);
+                rb.centroidBounds = AABB(rb.centroidBounds, p.centroidBounds);
+            }
+
+            return rb;
+        }
+
+        template <typename BinIndexFn>
+        BVHBins ComputeBins(const SAHBuildState& state, u32 start, u32 end, BinIndexFn&& BinIndex)
+        {
+            auto Bin = [&](u32 first, u32 last) -> BVHBins {
+                BVHBins bins;
+                for (u32 i = first; i < last; ++i) {
+                    const BVHPrimitiveInfo& info = state.primitiveInfo[i];
+                    BVHBin& bin = bins[BinIndex(info)];
+                    bin.count++;
+                    bin.bounds = AABB(bin.bounds, info.bounds);
+                }
+                return bins;
+            };
+
+            u32 n = end - start;
+            if (n < s_ParallelBinThreshold) {
+                return Bin(start, end);
+            }
+
+            u32 chunks = (n + s_ParallelChunkSize - 1) / s_ParallelChunkSize;
+            std::vector<BVHBins> partial(chunks);
+
+            JobContext context;
+            JobSystem::Dispatch(context, chunks, 1, [&](JobDispatchArgs args) {
+                u32 first = start + args.jobIndex * s_ParallelChunkSize;
+                u32 last = std::min(first + s_ParallelChunkSize, end);
+                partial[args.jobIndex] = Bin(first, last);
+            });
+            JobSystem::Wait(context);
+
+            BVHBins bins;
+            for (const BVHBins& p : partial) {
+                for (u32 b = 0; b < s_MaxBins; ++b) {
+                    bins[b].count += p[b].count;
+                    bins[b].bounds = AABB(bins[b].bounds, p[b].bounds);
+                }
+            }
+
+            return bins;
+        }
+
+        // Unnormalized SAH cost of the best plane between bins, the split keeps bins [0, index] below
+        BinSplit SweepBins(const BVHBins& bins, u32 nBins, const BVH::Config& config)
+        {
+            // Sweep from the right to get the bounds and count above every split plane
+            std::array<AABB, s_MaxBins> boundsAbove;
+            std::array<u32, s_MaxBins> countAbove;
+
+            AABB accumBounds;
+            u32 accumCount = 0;
+            for (u32 i = nBins - 1; i > 0; --i) {
+                accumBounds = AABB(accumBounds, bins[i].bounds);
+                accumCount += bins[i].count;
+                boundsAbove[i - 1] = accumBounds;
+                countAbove[i - 1] = accumCount;
+            }
+
+            BinSplit best;
+
+            AABB boundsBelow;
+            u32 countBelow = 0;
+            for (u32 i = 0; i < nBins - 1; ++i) {
+                boundsBelow = AABB(boundsBelow, bins[i].bounds);
+                countBelow += bins[i].count;
+
+                if (countBelow == 0 || countAbove[i] == 0) continue;
+
+                f32 cost = BVHBuilder::LeafTests(config, countBelow) * boundsBelow.SurfaceArea()
+                    + BVHBuilder::LeafTests(config, countAbove[i]) * boundsAbove[i].SurfaceArea();
+                if (cost < best.cost) {
+                    best = { cost, i, boundsBelow, boundsAbove[i], countBelow, countAbove[i] };
+                }
+            }
+
+            return best;
+        }
+
+        BVHBuildNode* BuildBVHRecursive(SAHBuildState& state, u32 start, u32 end, u32 depth)
+        {
+            const BVH::Config& config = state.config;
+
+            BVHBuildNode* node = state.AllocateNode();
+
+            RangeBounds rb = ComputeRangeBounds(state, start, end);
+            const AABB& bbox = rb.bounds;
+
+            u32 nPrimitives = end - start;
+            if (nPrimitives == 1) {
+                node->InitLeaf(start, nPrimitives, bbox);
+                return node;
+            }
+
+            u32 axis = rb.centroidBounds.MaxExtentAxis();
+            const Bounds& axisBounds = rb.centroidBounds.AxisBounds(axis);
+
+            u32 mid = (start + end) / 2;
+
+            if (depth >= s_MaxCostDepth) {
+                if (nPrimitives <= config.maxPrimitivesInLeaf) {
+                    node->InitLeaf(start, nPrimitives, bbox);
+                    return node;
+                }
+
+                std::nth_element(state.primitiveInfo.begin() + start, state.primitiveInfo.begin() + mid, state.primitiveInfo.begin() + end,
+                    [axis](const BVHPrimitiveInfo& a, const BVHPrimitiveInfo& b) {
+                        return a.centroid[axis] < b.centroid[axis];
+                    }
+                );
+            } else if (axisBounds.Size() <= 0.0f) {
+                // All centroids coincide, SAH has nothing to bin
+                if (nPrimitives <= config.maxPrimitivesInLeaf) {
+                    node->InitLeaf(start, nPrimitives, bbox);
+                    return node;
+                }
+            } else {
+                const u32 nBins = std::clamp(config.bins, 2u, s_MaxBins);
+                const f32 binScale = static_cast<f32>(nBins) / axisBounds.Size();
+
+                auto BinIndex = [axis, nBins, binScale, &axisBounds](const BVHPrimitiveInfo& info) -> u32 {
+                    u32 b = static_cast<u32>((info.centroid[axis] - axisBounds.min) * binScale);
+                    return std::min(b, nBins - 1);
+                };
+
+                BVHBins bins = ComputeBins(state, start, end, BinIndex);
+
+                BinSplit split = SweepBins(bins, nBins, config);
+                u32 minCostSplit = split.index;
+
+                f32 nodeArea = bbox.SurfaceArea();
+                f32 splitCost = config.traversalCost + config.intersectionCost * (nodeArea > 0.0f ? split.cost / nodeArea : 0.0f);
+                f32 leafCost = config.intersectionCost * BVHBuilder::LeafTests(config, nPrimitives);
+
+                if (nPrimitives <= config.maxPrimitivesInLeaf && leafCost <= splitCost) {
+                    node->InitLeaf(start, nPrimitives, bbox);
+                    return node;
+                }
+
+                auto pmid = std::partition(state.primitiveInfo.begin() + start, state.primitiveInfo.begin() + end,
+                    [&](const BVHPrimitiveInfo& info) -> bool {
+                        return BinIndex(info) <= minCostSplit;
+                    }
+                );
+
+                u32 partitioned = static_cast<u32>(pmid - state.primitiveInfo.begin());
+                if (partitioned != start && partitioned != end) {
+                    mid = partitioned;
+                }
+            }
+
+            BVHBuildNode* children[2];
+
+            if (nPrimitives >= s_ParallelBuildThreshold) {
+                JobContext context;
+                JobSystem::Execute(context, [&]() {
+                    children[0] = BuildBVHRecursive(state, start, mid, depth + 1);
+                });
+                children[1] = BuildBVHRecursive(state, mid, end, depth + 1);
+                JobSystem::Wait(context);
+            } else {
+                children[0] = BuildBVHRecursive(state, start, mid, depth + 1);
+                children[1] = BuildBVHRecursive(state, mid, end, depth + 1);
+            }
+
+            node->InitInterior(axis, children[0], children[1]);
+
+            return node;
+        }
+
+        struct SBVHReference
+        {
+            u32 index;
+            AABB bounds;
+        };
+
+        struct SpatialBin
+        {
+            AABB bounds;
+            u32 entries { 0 };
+            u32 exits { 0 };
+        };
+
+        struct SpatialSplit
+        {
+            f32 cost { std::numeric_limits<f32>::infinity() };
+            u32 axis { 0 };
+            f32 position { 0.0f };
+            AABB below;
+            AABB above;
+            u32 countBelow { 0 };
+            u32 countAbove { 0 };
+        };
+
+        struct SBVHBuildState
+        {
+            const BVH::Config& config;
+            const BVHBuilder::ClipBoundFn& clipBound;
+
+            // Spatial splits are only tried when the object split children overlap by more than this area
+            f32 minOverlapArea;
+
+            // Every leaf holds at least one reference, so the arena is sized from the duplication cap
+            u32 maxReferences;
+            std::atomic<u32> referenceCount;
+            std::atomic<u32> spatialSplits { 0 };
+
+            std::vector<BVHBuildNode> arena;
+            std::atomic<u32> nodeCount { 0 };
+
+            std::vector<u32> primitiveIndices;
+            std::atomic<u32> primitiveCount { 0 };
+
+            SBVHBuildState(const BVH::Config& config, const BVHBuilder::ClipBoundFn& clipBound, u32 nPrimitives, f32 rootArea)
+                : config(config), clipBound(clipBound),
+                  minOverlapArea(config.spatialSplitOverlap * rootArea),
+                  maxReferences(nPrimitives + static_cast<u32>(nPrimitives * std::max(config.maxDuplication, 0.0f))),
+                  referenceCount(nPrimitives),
+                  arena(2 * maxReferences - 1),
+                  primitiveIndices(maxReferences)
+            {
+            }
+
+            BVHBuildNode* AllocateNode()
+            {
+                return &arena[nodeCount.fetch_add(1)];
+            }
+
+            bool ReserveReferences(u32 count)
+            {
+                u32 current = referenceCount.load();
+                do {
+                    if (current + count > maxReferences) return false;
+                } while (!referenceCount.compare_exchange_weak(current, current + count));
+
+                return true;
+            }
+
+            void ReleaseReferences(u32 count)
+            {
+                referenceCount.fetch_sub(count);
+            }
+        };
+
+        AABB ClampAxis(const AABB& box, u32 axis, f32 min, f32 max)
+        {
+            AABB result = box;
+            Bounds& bounds = (axis == 0) ? result.x : (axis == 1) ? result.y : result.z;
+            bounds.min = std::max(bounds.min, min);
+            bounds.max = std::min(bounds.max, max);
+            return result;
+        }
+
+        SpatialSplit FindSpatialSplit(const SBVHBuildState& state, const std::vector<SBVHReference>& refs, const AABB& bbox, u32 nBins)
+        {
+            constexpr f32 infinity = std::numeric_limits<f32>::infinity();
+
+            auto EvaluateAxis = [&](u32 axis) -> SpatialSplit {
+                SpatialSplit best;
+
+                const Bounds& axisBounds = bbox.AxisBounds(axis);
+                if (axisBounds.Size() <= 0.0f) return best;
+
+                const f32 binSize = axisBounds.Size() / nBins;
+                const f32 invBinSize = static_cast<f32>(nBins) / axisBounds.Size();
+
+                auto BinIndex = [&](f32 x) -> u32 {
+                    i32 b = static_cast<i32>((x - axisBounds.min) * invBinSize);
+                    return static_cast<u32>(std::clamp(b, 0, static_cast<i32>(nBins) - 1));
+                };
+
+                // Straddling references are clipped into every bin they touch
+                std::array<SpatialBin, s_MaxBins> bins;
+                for (const SBVHReference& ref : refs) {
+                    const Bounds& refBounds = ref.bounds.AxisBounds(axis);
+                    u32 first = BinIndex(refBounds.min);
+                    u32 last = BinIndex(refBounds.max);
+
+                    bins[first].entries++;
+                    bins[last].exits++;
+
+                    if (first == last) {
+                        bins[first].bounds = AABB(bins[first].bounds, ref.bounds);
+                        continue;
+                    }
+
+                    for (u32 b = first; b <= last; ++b) {
+                        f32 lo = (b == first) ? -infinity : axisBounds.min + b * binSize;
+                        f32 hi = (b == last) ? infinity : axisBounds.min + (b + 1) * binSize;
+
+                        AABB clipped = state.clipBound(ref.index, ClampAxis(ref.bounds, axis, lo, hi));
+                        if (!clipped.IsEmpty()) {
+                            bins[b].bounds = AABB(bins[b].bounds, clipped);
+                        }
+                    }
+                }
+
+                std::array<AABB, s_MaxBins> boundsAbove;
+                std::array<u32, s_MaxBins> countAbove;
+
+                AABB accumBounds;
+                u32 accumCount = 0;
+                for (u32 i = nBins - 1; i > 0; --i) {
+                    accumBounds = AABB(accumBounds, bins[i].bounds);
+                    accumCount += bins[i].exits;
+                    boundsAbove[i - 1] = accumBounds;
+                    countAbove[i - 1] = accumCount;
+                }
+
+                AABB boundsBelow;
+                u32 countBelow = 0;
+                for (u32 i = 0; i < nBins - 1; ++i) {
+                    boundsBelow = AABB(boundsBelow, bins[i].bounds);
+                    countBelow += bins[i].entries;
+
+                    if (countBelow == 0 || countAbove[i] == 0) continue;
+
+                    f32 cost = BVHBuilder::LeafTests(state.config, countBelow) * boundsBelow.SurfaceArea()
+                        + BVHBuilder::LeafTests(state.config, countAbove[i]) * boundsAbove[i].SurfaceArea();
+                    if (cost < best.cost) {
+                        best = { cost, axis, axisBounds.min + (i + 1) * binSize, boundsBelow, boundsAbove[i], countBelow, countAbove[i] };
+                    }
+                }
+
+                return best;
+            };
+
+            std::array<SpatialSplit, 3> splits;
+            if (refs.size() >= s_ParallelBuildThreshold) {
+                JobContext context;
+                JobSystem::Dispatch(context, 3, 1, [&](JobDispatchArgs args) {
+                    splits[args.jobIndex] = EvaluateAxis(args.jobIndex);
+                });
+                JobSystem::Wait(context);
+            } else {
+                for (u32 axis = 0; axis < 3; ++axis) {
+                    splits[axis] = EvaluateAxis(axis);
+                }
+            }
+
+            SpatialSplit best = splits[0];
+            for (u32 axis = 1; axis < 3; ++axis) {
+                if (splits[axis].cost < best.cost) best = splits[axis];
+            }
+
+            return best;
+        }
+
+        // Returns false when the split would exceed the duplication budget or leave a side empty
+        bool SpatialPartition(SBVHBuildState& state, const std::vector<SBVHReference>& refs, const SpatialSplit& split,
+                              std::vector<SBVHReference>& left, std::vector<SBVHReference>& right)
+        {
+            constexpr f32 infinity = std::numeric_limits<f32>::infinity();
+
+            std::vector<const SBVHReference*> straddling;
+            for (const SBVHReference& ref : refs) {
+                const Bounds& refBounds = ref.bounds.AxisBounds(split.axis);
+                if (refBounds.max <= split.position) {
+                    left.push_back(ref);
+                } else if (refBounds.min >= split.position) {
+                    right.push_back(ref);
+                } else {
+                    straddling.push_back(&ref);
+                }
+            }
+
+            u32 reserved = static_cast<u32>(straddling.size());
+            if (!state.ReserveReferences(reserved)) {
+                left.clear();
+                right.clear();
+                return false;
+            }
+
+            // Reference unsplitting: keep a straddler whole on one side when that is cheaper than duplicating it
+            AABB leftBounds = split.below;
+            AABB rightBounds = split.above;
+            u32 leftCount = split.countBelow;
+            u32 rightCount = split.countAbove;
+            u32 duplicated = 0;
+
+            for (const SBVHReference* ref : straddling) {
+                AABB leftPart = state.clipBound(ref->index, ClampAxis(ref->bounds, split.axis, -infinity, split.position));
+                AABB rightPart = state.clipBound(ref->index, ClampAxis(ref->bounds, split.axis, split.position, infinity));
+
+                if (leftPart.IsEmpty() || rightPart.IsEmpty()) {
+                    (leftPart.IsEmpty() ? right : left).push_back(*ref);
+                    continue;
+                }
+
+                f32 leftArea = leftBounds.SurfaceArea();
+                f32 rightArea = rightBounds.SurfaceArea();
+
+                f32 splitCost = leftArea * leftCount + rightArea * rightCount;
+                f32 leftCost = AABB(leftBounds, ref->bounds).SurfaceArea() * leftCount + rightArea * (rightCount - 1);
+                f32 rightCost = leftArea * (leftCount - 1) + AABB(rightBounds, ref->bounds).SurfaceArea() * rightCount;
+
+                if (leftCost < splitCost && leftCost <= rightCost) {
+                    left.push_back(*ref);
+                    leftBounds = AABB(leftBounds, ref->bounds);
+                    rightCount--;
+                } else if (rightCost < splitCost) {
+                    right.push_back(*ref);
+                    rightBounds = AABB(rightBounds, ref->bounds);
+                    leftCount--;
+                } else {
+                    left.push_back({ ref->index, leftPart });
+                    right.push_back({ ref->index, rightPart });
+                    duplicated++;
+                }
+            }
+
+            state.ReleaseReferences(reserved - duplicated);
+
+            if (left.empty() || right.empty()) {
+                state.ReleaseReferences(duplicated);
+                left.clear();
+                right.clear();
+                return false;
+            }
+
+            return true;
+        }
+
+        BVHBuildNode* BuildSBVHRecursive(SBVHBuildState& state, std::vector<SBVHReference>& refs, u32 depth)
+        {
+            const BVH::Config& config = state.config;
+
+            BVHBuildNode* node = state.AllocateNode();
+
+            AABB bbox;
+            AABB centroidBounds;
+            for (const SBVHReference& ref : refs) {
+                glm::vec3 centroid = ref.bounds.Centroid();
+                bbox = AABB(bbox, ref.bounds);
+                centroidBounds = AABB(centroidBounds, AABB(centroid, centroid));
+            }
+
+            u32 nPrimitives = static_cast<u32>(refs.size());
+
+            auto MakeLeaf = [&]() {
+                u32 offset = state.primitiveCount.fetch_add(nPrimitives);
+                for (u32 i = 0; i < nPrimitives; ++i) {
+                    state.primitiveIndices[offset + i] = refs[i].index;
+                }
+                node->InitLeaf(offset, nPrimitives, bbox);
+                return node;
+            };
+
+            if (nPrimitives == 1) return MakeLeaf();
+
+            const u32 nBins = std::clamp(config.bins, 2u, s_MaxBins);
+
+            u32 axis = centroidBounds.MaxExtentAxis();
+            const Bounds& axisBounds = centroidBounds.AxisBounds(axis);
+            const f32 binScale = axisBounds.Size() > 0.0f ? static_cast<f32>(nBins) / axisBounds.Size() : 0.0f;
+
+            auto BinIndex = [axis, nBins, binScale, &axisBounds](const SBVHReference& ref) -> u32 {
+                u32 b = static_cast<u32>((ref.bounds.Centroid()[axis] - axisBounds.min) * binScale);
+                return std::min(b, nBins - 1);
+            };
+
+            // Past the cost depth neither split is searched, the node goes to the median below, which also
+            // stops straddling references from recursing forever
+            const bool searchSplits = depth < s_MaxCostDepth;
+
+            BinSplit objectSplit;
+            if (searchSplits && axisBounds.Size() > 0.0f) {
+                BVHBins bins;
+                for (const SBVHReference& ref : refs) {
+                    BVHBin& bin = bins[BinIndex(ref)];
+                    bin.count++;
+                    bin.bounds = AABB(bin.bounds, ref.bounds);
+                }
+                objectSplit = SweepBins(bins, nBins, config);
+            }
+
+            SpatialSplit spatialSplit;
+            bool overlapping = !(objectSplit.cost < std::numeric_limits<f32>::infinity())
+                || objectSplit.below.Overlap(objectSplit.above).SurfaceArea() > state.minOverlapArea;
+
+            bool budgetLeft = state.referenceCount.load() < state.maxReferences;
+
+            if (searchSplits && overlapping && budgetLeft) {
+                spatialSplit = FindSpatialSplit(state, refs, bbox, nBins);
+            }
+
+            f32 minCost = std::min(objectSplit.cost, spatialSplit.cost);
+
+            f32 nodeArea = bbox.SurfaceArea();
+            f32 splitCost = config.traversalCost + config.intersectionCost * (nodeArea > 0.0f ? minCost / nodeArea : 0.0f);
+            f32 leafCost = config.intersectionCost * BVHBuilder::LeafTests(config, nPrimitives);
+
+            if (nPrimitives <= config.maxPrimitivesInLeaf && leafCost <= splitCost) {
+                return MakeLeaf();
+            }
+
+            std::vector<SBVHReference> left;
+            std::vector<SBVHReference> right;
+
+            bool split = false;
+            if (spatialSplit.cost < objectSplit.cost) {
+                split = SpatialPartition(state, refs, spatialSplit, left, right);
+                if (split) {
+                    axis = spatialSplit.axis;
+                    state.spatialSplits.fetch_add(1);
+                }
+            }
+
+            if (!split && objectSplit.cost < std::numeric_limits<f32>::infinity()) {
+                for (const SBVHReference& ref : refs) {
+                    (BinIndex(ref) <= objectSplit.index ? left : right).push_back(ref);
+                }
+                split = !left.empty() && !right.empty();
+            }
+
+            if (!split) {
+                if (nPrimitives <= config.maxPrimitivesInLeaf) return MakeLeaf();
+
+                std::nth_element(refs.begin(), refs.begin() + nPrimitives / 2, refs.end(),
+                    [axis](const SBVHReference& a, const SBVHReference& b) {
+                        return a.bounds.Centroid()[axis] < b.bounds.Centroid()[axis];
+                    }
+                );
+
+                left.assign(refs.begin(), refs.begin() + nPrimitives / 2);
+                right.assign(refs.begin() + nPrimitives / 2, refs.end());
+            }
+
+            // The children own their references from here on
+            std::vector<SBVHReference>().swap(refs);
+
+            BVHBuildNode* children[2];
+
+            if (nPrimitives >= s_ParallelBuildThreshold) {
+                JobContext context;
+                JobSystem::Execute(context, [&]() {
+                    children[0] = BuildSBVHRecursive(state, left, depth + 1);
+                });
+                children[1] = BuildSBVHRecursive(state, right, depth + 1);
+                JobSystem::Wait(context);
+            } else {
+                children[0] = BuildSBVHRecursive(state, left, depth + 1);
+                children[1] = BuildSBVHRecursive(state, right, depth + 1);
+            }
+
+            node->InitInterior(axis, children[0], children[1]);
+
+            return node;
+        }
+
+        // Interleaves the low 10 bits of v with two zero bits between each
+        u32 ExpandBits10(u32 v)
+        {
+            v &= 0x3ff;
+            v = (v | (v << 16)) & 0x030000ff;
+            v = (v | (v << 8)) & 0x0300f00f;
+            v = (v | (v << 4)) & 0x030c30c3;
+            v = (v | (v << 2)) & 0x09249249;
+            return v;
+        }
+
+        u64 ExpandBits21(u64 v)
+        {
+            v &= 0x1fffff;
+            v = (v | (v << 32)) & 0x001f00000000ffffULL;
+            v = (v | (v << 16)) & 0x001f0000ff0000ffULL;
+            v = (v | (v << 8)) & 0x100f00f00f00f00fULL;
+            v = (v | (v << 4)) & 0x10c30c30c30c30c3ULL;
+            v = (v | (v << 2)) & 0x1249249249249249ULL;
+            return v;
+        }
+
+        struct MortonPrimitive
+        {
+            u64 code;
+            u32 index;
+        };
+
+        // Stable LSD radix sort, every pass builds per-chunk digit histograms and scatters the chunks in parallel
+        void RadixSort(std::vector<MortonPrimitive>& primitives, u32 keyBits)
+        {
+            u32 n = static_cast<u32>(primitives.size());
+            u32 chunks = (n + s_ParallelChunkSize - 1) / s_ParallelChunkSize;
+
+            std::vector<MortonPrimitive> scratch(n);
+            std::vector<std::array<u32, s_RadixBuckets>> histograms(chunks);
+
+            for (u32 shift = 0; shift < keyBits; shift += s_RadixBits) {
+                auto Digit = [shift](const MortonPrimitive& p) { return static_cast<u32>((p.code >> shift) & (s_RadixBuckets - 1)); };
+
+                JobContext context;
+                JobSystem::Dispatch(context, chunks, 1, [&](JobDispatchArgs args) {
+                    std::array<u32, s_RadixBuckets>& histogram = histograms[args.jobIndex];
+                    histogram.fill(0);
+
+                    u32 first = args.jobIndex * s_ParallelChunkSize;
+                    u32 last = std::min(first + s_ParallelChunkSize, n);
+                    for (u32 i = first; i < last; ++i) {
+                        histogram[Digit(primitives[i])]++;
+                    }
+                });
+                JobSystem::Wait(context);
+
+                // Bucket-major prefix sum turns the histograms into scatter offsets
+                u32 offset = 0;
+                for (u32 b = 0; b < s_RadixBuckets; ++b) {
+                    for (u32 c = 0; c < chunks; ++c) {
+                        u32 count = histograms[c][b];
+                        histograms[c][b] = offset;
+                        offset += count;
+                    }
+                }
+
+                JobSystem::Dispatch(context, chunks, 1, [&](JobDispatchArgs args) {
+                    std::array<u32, s_RadixBuckets>& offsets = histograms[args.jobIndex];
+
+                    u32 first = args.jobIndex * s_ParallelChunkSize;
+                    u32 last = std::min(first + s_ParallelChunkSize, n);
+                    for (u32 i = first; i < last; ++i) {
+                        scratch[offsets[Digit(primitives[i])]++] = primitives[i];
+                    }
+                });
+                JobSystem::Wait(context);
+
+                primitives.swap(scratch);
+            }
+        }
+
+        // Indices below n - 1 are internal nodes, the n leaves follow in Morton order
+        struct LBVHNode
+        {
+            AABB bounds;
+            u32 children[2];
+            u32 nPrimitives;
+            u32 subtreeSize;
+            f32 cost;
+        };
+
+        struct LBVHBuildState
+        {
+            const BVH::Config& config;
+            std::vector<MortonPrimitive> primitives;
+            std::vector<LBVHNode> nodes;
+            u32 leafOffset;
+
+            std::vector<u32> primitiveIndices;
+        };
+
+        // Common prefix length of two sorted codes, equal codes are told apart by their index
+        i32 CommonPrefix(const std::vector<MortonPrimitive>& primitives, i32 i, i32 j)
+        {
+            if (j < 0 || j >= static_cast<i32>(primitives.size())) return -1;
+
+            u64 a = primitives[i].code;
+            u64 b = primitives[j].code;
+            if (a == b) {
+                return 64 + std::countl_zero(static_cast<u32>(i ^ j));
+            }
+
+            return std::countl_zero(a ^ b);
+        }
+
+        // Karras 2012: every internal node finds its key range and split independently
+        void EmitInternalNode(LBVHBuildState& state, i32 i)
+        {
+            const std::vector<MortonPrimitive>& primitives = state.primitives;
+
+            i32 d = (CommonPrefix(primitives, i, i + 1) - CommonPrefix(primitives, i, i - 1)) >= 0 ? 1 : -1;
+            i32 minPrefix = CommonPrefix(primitives, i, i - d);
+
+            i32 maxLength = 2;
+            while (CommonPrefix(primitives, i, i + maxLength * d) > minPrefix) {
+                maxLength *= 2;
+            }
+
+            i32 length = 0;
+            for (i32 t = maxLength / 2; t >= 1; t /= 2) {
+                if (CommonPrefix(primitives, i, i + (length + t) * d) > minPrefix) {
+                    length += t;
+                }
+            }
+
+            i32 j = i + length * d;
+            i32 nodePrefix = CommonPrefix(primitives, i, j);
+
+            i32 split = 0;
+            i32 divisor = 2;
+            i32 t;
+            do {
+                t = (length + divisor - 1) / divisor;
+                if (CommonPrefix(primitives, i, i + (split + t) * d) > nodePrefix) {
+                    split += t;
+                }
+                divisor *= 2;
+            } while (t > 1);
+
+            i32 gamma = i + split * d + std::min(d, 0);
+
+            LBVHNode& node = state.nodes[i];
+            node.nPrimitives = static_cast<u32>(std::abs(j - i)) + 1;
+            node.children[0] = (std::min(i, j) == gamma) ? state.leafOffset + gamma : gamma;
+            node.children[1] = (std::max(i, j) == gamma + 1) ? state.leafOffset + gamma + 1 : gamma + 1;
+        }
+
+        f32 SplitCost(const LBVHBuildState& state, const LBVHNode& node)
+        {
+            return state.config.traversalCost * node.bounds.SurfaceArea()
+                + state.nodes[node.children[0]].cost + state.nodes[node.children[1]].cost;
+        }
+
+        f32 LeafCost(const LBVHBuildState& state, const AABB& bounds, u32 nPrimitives)
+        {
+            return state.config.intersectionCost * BVHBuilder::LeafTests(state.config, nPrimitives) * bounds.SurfaceArea();
+        }
+
+        // Unnormalized SAH cost where small subtrees may collapse into a single leaf
+        void UpdateNode(LBVHBuildState& state, u32 index)
+        {
+            LBVHNode& node = state.nodes[index];
+            const LBVHNode& left = state.nodes[node.children[0]];
+            const LBVHNode& right = state.nodes[node.children[1]];
+
+            node.bounds = AABB(left.bounds, right.bounds);
+            node.nPrimitives = left.nPrimitives + right.nPrimitives;
+
+            f32 splitCost = SplitCost(state, node);
+            f32 leafCost = LeafCost(state, node.bounds, node.nPrimitives);
+
+            if (node.nPrimitives <= state.config.maxPrimitivesInLeaf && leafCost <= splitCost) {
+                node.cost = leafCost;
+                node.subtreeSize = 1;
+            } else {
+                node.cost = splitCost;
+                node.subtreeSize = 1 + left.subtreeSize + right.subtreeSize;
+            }
+        }
+
+        template <typename Fn>
+        void VisitChildren(u32 nPrimitives, Fn&& visit)
+        {
+            if (nPrimitives >= s_ParallelBuildThreshold) {
+                JobContext context;
+                JobSystem::Execute(context, [&]() { visit(0); });
+                visit(1);
+                JobSystem::Wait(context);
+            } else {
+                visit(0);
+                visit(1);
+            }
+        }
+
+        void ComputeLBVHBounds(LBVHBuildState& state, u32 index)
+        {
+            if (index >= state.leafOffset) return;
+
+            // Still the Morton range size at this point, the bounds pass overwrites it with the same count
+            VisitChildren(state.nodes[index].nPrimitives, [&](u32 child) {
+                ComputeLBVHBounds(state, state.nodes[index].children[child]);
+            });
+
+            UpdateNode(state, index);
+        }
+
+        // Karras & Aila 2013: regrow a treelet of up to seven leaves below root and pick its optimal topology
+        void OptimizeTreelet(LBVHBuildState& state, u32 root)
+        {
+            std::array<u32, s_TreeletLeaves> leaves;
+            std::array<u32, s_TreeletLeaves - 1> internals;
+            u32 nLeaves = 0;
+            u32 nInternals = 0;
+
+            internals[nInternals++] = root;
+            leaves[nLeaves++] = state.nodes[root].children[0];
+            leaves[nLeaves++] = state.nodes[root].children[1];
+
+            while (nLeaves < s_TreeletLeaves) {
+                i32 best = -1;
+                f32 bestArea = -1.0f;
+                for (u32 i = 0; i < nLeaves; ++i) {
+                    if (leaves[i] >= state.leafOffset) continue;
+
+                    f32 area = state.nodes[leaves[i]].bounds.SurfaceArea();
+                    if (area > bestArea) {
+                        bestArea = area;
+                        best = static_cast<i32>(i);
+                    }
+                }
+
+                if (best < 0) break;
+
+                u32 expanded = leaves[best];
+                internals[nInternals++] = expanded;
+                leaves[best] = state.nodes[expanded].children[0];
+                leaves[nLeaves++] = state.nodes[expanded].children[1];
+            }
+
+            if (nLeaves < 3) return;
+
+            const u32 nSubsets = 1u << nLeaves;
+            std::array<f32, 1u << s_TreeletLeaves> cost;
+            std::array<AABB, 1u << s_TreeletLeaves> bounds;
+            std::array<u32, 1u << s_TreeletLeaves> count;
+            std::array<u32, 1u << s_TreeletLeaves> partition;
+
+            for (u32 s = 1; s < nSubsets; ++s) {
+                u32 lowest = static_cast<u32>(std::countr_zero(s));
+                u32 rest = s & (s - 1);
+
+                if (rest == 0) {
+                    const LBVHNode& leaf = state.nodes[leaves[lowest]];
+                    bounds[s] = leaf.bounds;
+                    count[s] = leaf.nPrimitives;
+                    cost[s] = leaf.cost;
+                    continue;
+                }
+
+                bounds[s] = AABB(bounds[1u << lowest], bounds[rest]);
+                count[s] = count[1u << lowest] + count[rest];
+
+                // Enumerate partitions that keep the lowest leaf on the left to visit each split once
+                f32 bestSplit = std::numeric_limits<f32>::infinity();
+                u32 bestPartition = 1u << lowest;
+                for (u32 p = (rest - 1) & rest; ; p = (p - 1) & rest) {
+                    u32 leftSet = p | (1u << lowest);
+                    u32 rightSet = s & ~leftSet;
+                    if (rightSet != 0) {
+                        f32 c = cost[leftSet] + cost[rightSet];
+                        if (c < bestSplit) {
+                            bestSplit = c;
+                            bestPartition = leftSet;
+                        }
+                    }
+                    if (p == 0) break;
+                }
+
+                f32 area = bounds[s].SurfaceArea();
+                cost[s] = state.config.traversalCost * area + bestSplit;
+                if (count[s] <= state.config.maxPrimitivesInLeaf) {
+                    cost[s] = std::min(cost[s], LeafCost(state, bounds[s], count[s]));
+                }
+                partition[s] = bestPartition;
+            }
+
+            if (!(cost[nSubsets - 1] < state.nodes[root].cost)) return;
+
+            // Reuse the treelet's internal nodes for the new topology, root stays in place
+            u32 nextInternal = 1;
+            auto Rebuild = [&](auto&& self, u32 s, u32 nodeIndex) -> void {
+                u32 leftSet = partition[s];
+                u32 rightSet = s & ~leftSet;
+
+                u32 subsets[2] = { leftSet, rightSet };
+                for (u32 c = 0; c < 2; ++c) {
+                    if ((subsets[c] & (subsets[c] - 1)) == 0) {
+                        state.nodes[nodeIndex].children[c] = leaves[std::countr_zero(subsets[c])];
+                    } else {
+                        u32 child = internals[nextInternal++];
+                        state.nodes[nodeIndex].children[c] = child;
+                        self(self, subsets[c], child);
+                    }
+                }
+
+                UpdateNode(state, nodeIndex);
+            };
+
+            Rebuild(Rebuild, nSubsets - 1, root);
+        }
+
+        void OptimizeTreelets(LBVHBuildState& state, u32 index)
+        {
+            if (index >= state.leafOffset) return;
+
+            VisitChildren(state.nodes[index].nPrimitives, [&](u32 child) {
+                OptimizeTreelets(state, state.nodes[index].children[child]);
+            });
+
+            OptimizeTreelet(state, index);
+        }
+
+        void CollectSubtree(const LBVHBuildState& state, u32 index, std::vector<u32>& leaves, std::vector<u32>& internals)
+        {
+            if (index >= state.leafOffset) {
+                leaves.push_back(index);
+                return;
+            }
+
+            internals.push_back(index);
+            CollectSubtree(state, state.nodes[index].children[0], leaves, internals);
+            CollectSubtree(state, state.nodes[index].children[1], leaves, internals);
+        }
+
+        // Rebuilds the subtree below index as a balanced tree over its leaves in Morton order, reusing its internal nodes
+        void BalanceSubtree(LBVHBuildState& state, u32 index)
+        {
+            std::vector<u32> leaves;
+            std::vector<u32> internals;
+            CollectSubtree(state, index, leaves, internals);
+
+            std::sort(leaves.begin(), leaves.end());
+
+            u32 nextInternal = 0;
+            auto Rebuild = [&](auto&& self, u32 first, u32 last) -> u32 {
+                if (first == last) return leaves[first];
+
+                u32 nodeIndex = internals[nextInternal++];
+                u32 mid = (first + last) / 2;
+                state.nodes[nodeIndex].children[0] = self(self, first, mid);
+                state.nodes[nodeIndex].children[1] = self(self, mid + 1, last);
+
+                UpdateNode(state, nodeIndex);
+                return nodeIndex;
+            };
+
+            Rebuild(Rebuild, 0, static_cast<u32>(leaves.size()) - 1);
+        }
+
+        // Karras splits follow the code bits, so 63-bit codes and duplicates can nest far deeper than the traversal
+        // stacks hold. Subtrees still emitted past s_MaxCostDepth are balanced, returns whether anything below changed.
+        bool LimitLBVHDepth(LBVHBuildState& state, u32 index, u32 depth)
+        {
+            if (index >= state.leafOffset || state.nodes[index].subtreeSize == 1) return false;
+
+            if (depth >= s_MaxCostDepth) {
+                BalanceSubtree(state, index);
+                return true;
+            }
+
+            bool changed[2] = { false, false };
+            VisitChildren(state.nodes[index].nPrimitives, [&](u32 child) {
+                changed[child] = LimitLBVHDepth(state, state.nodes[index].children[child], depth + 1);
+            });
+
+            if (!changed[0] && !changed[1]) return false;
+
+            UpdateNode(state, index);
+            return true;
+        }
+
+        void GatherPrimitives(LBVHBuildState& state, u32 index, u32& offset)
+        {
+            if (index >= state.leafOffset) {
+                state.primitiveIndices[offset++] = state.primitives[index - state.leafOffset].index;
+                return;
+            }
+
+            GatherPrimitives(state, state.nodes[index].children[0], offset);
+            GatherPrimitives(state, state.nodes[index].children[1], offset);
+        }
+
+        // Writes the depth-first layout directly, subtree sizes and primitive counts fix every offset
+        void EmitLBVH(LBVHBuildState& state, u32 index, std::vector<LinearBVHNode>& nodes, u32 nodeOffset, u32 primitiveOffset)
+        {
+            const LBVHNode& node = state.nodes[index];
+            LinearBVHNode& linearNode = nodes[nodeOffset];
+
+            linearNode.bounds = node.bounds;
+            linearNode.pad = 0;
+
+            if (index >= state.leafOffset || node.subtreeSize == 1) {
+                u32 offset = primitiveOffset;
+                GatherPrimitives(state, index, offset);
+
+                linearNode.primitivesOffset = primitiveOffset;
+                linearNode.nPrimitives = static_cast<u16>(node.nPrimitives);
+                linearNode.axis = 0;
+                return;
+            }
+
+            // Traversal picks the near child by the split axis, so order the children along it
+            u32 children[2] = { node.children[0], node.children[1] };
+            glm::vec3 delta = state.nodes[children[1]].bounds.Centroid() - state.nodes[children[0]].bounds.Centroid();
+            u32 axis = AABB(glm::vec3(0.0f), glm::abs(delta)).MaxExtentAxis();
+            if (delta[axis] < 0.0f) {
+                std::swap(children[0], children[1]);
+            }
+
+            const LBVHNode& left = state.nodes[children[0]];
+
+            u32 secondChildOffset = nodeOffset + 1 + left.subtreeSize;
+            linearNode.nPrimitives = 0;
+            linearNode.axis = static_cast<u8>(axis);
+            linearNode.secondChildOffset = secondChildOffset;
+
+            VisitChildren(node.nPrimitives, [&](u32 child) {
+                if (child == 0) {
+                    EmitLBVH(state, children[0], nodes, nodeOffset + 1, primitiveOffset);
+                } else {
+                    EmitLBVH(state, children[1], nodes, secondChildOffset, primitiveOffset + left.nPrimitives);
+                }
+            });
+        }
+
+        void FlattenBVHTree(const BVHBuildNode* node, std::vector<LinearBVHNode>& nodes, u32 offset)
+        {
+            LinearBVHNode& linearNode = nodes[offset];
+
+            linearNode.bounds = node->bounds;
+            linearNode.nPrimitives = static_cast<u16>(node->nPrimitives);
+            linearNode.pad = 0;
+
+            if (node->nPrimitives > 0) {
+                linearNode.primitivesOffset = node->firstPrimOffset;
+                linearNode.axis = 0;
+                return;
+            }
+
+            // Subtree sizes fix every offset up front, so both children can be written independently
+            u32 firstChild = offset + 1;
+            u32 secondChild = firstChild + node->children[0]->subtreeSize;
+
+            linearNode.axis = static_cast<u8>(node->splitAxis);
+            linearNode.secondChildOffset = secondChild;
+
+            if (node->subtreeSize >= s_ParallelFlattenThreshold) {
+                JobContext context;
+                JobSystem::Execute(context, [&]() {
+                    FlattenBVHTree(node->children[0], nodes, firstChild);
+                });
+                FlattenBVHTree(node->children[1], nodes, secondChild);
+                JobSystem::Wait(context);
+            } else {
+                FlattenBVHTree(node->children[0], nodes, firstChild);
+                FlattenBVHTree(node->children[1], nodes, secondChild);
+            }
+        }
+
+    }
+
+    BVHBuildResult BVHBuilder::BuildSAH(const std::vector<AABB>& primitiveBounds, const BVH::Config& config)
+    {
+        BVHBuildResult result;
+        if (primitiveBounds.empty()) return result;
+
+        u32 nPrimitives = static_cast<u32>(primitiveBounds.size());
+
+        std::vector<BVHPrimitiveInfo> primitiveInfo(nPrimitives);
+        JobContext context;
+        JobSystem::Dispatch(context, nPrimitives, s_ParallelChunkSize, [&](JobDispatchArgs args) {
+            const AABB& bounds = primitiveBounds[args.jobIndex];
+            primitiveInfo[args.jobIndex] = { args.jobIndex, bounds, bounds.Centroid() };
+        });
+        JobSystem::Wait(context);
+
+        SAHBuildState state(primitiveInfo, config);
+        BVHBuildNode* root = BuildBVHRecursive(state, 0, nPrimitives, 0);
+
+        result.nodes.resize(root->subtreeSize);
+        FlattenBVHTree(root, result.nodes, 0);
+
+        result.primitiveIndices.resize(nPrimitives);
+        for (u32 i = 0; i < nPrimitives; ++i) {
+            result.primitiveIndices[i] = primitiveInfo[i].index;
+        }
+
+        return result;
+    }
+
+    BVHBuildResult BVHBuilder::BuildSBVH(const std::vector<AABB>& primitiveBounds, const ClipBoundFn& clipBound, const BVH::Config& config)
+    {
+        BVHBuildResult result;
+        if (primitiveBounds.empty()) return result;
+
+        u32 nPrimitives = static_cast<u32>(primitiveBounds.size());
+
+        std::vector<SBVHReference> refs(nPrimitives);
+        AABB rootBounds;
+        for (u32 i = 0; i < nPrimitives; ++i) {
+            refs[i] = { i, primitiveBounds[i] };
+            rootBounds = AABB(rootBounds, primitiveBounds[i]);
+        }
+
+        SBVHBuildState state(config, clipBound, nPrimitives, rootBounds.SurfaceArea());
+        BVHBuildNode* root = BuildSBVHRecursive(state, refs, 0);
+
+        result.nodes.resize(root->subtreeSize);
+        FlattenBVHTree(root, result.nodes, 0);
+
+        result.primitiveIndices.assign(state.primitiveIndices.begin(), state.primitiveIndices.begin() + state.primitiveCount.load());
+        result.spatialSplits = state.spatialSplits.load();
+
+        return result;
+    }
+
+    u64 BVHBuilder::MortonCode(const glm::vec3& centroid, const AABB& centroidBounds, u32 mortonBits)
+    {
+        f32 p[3];
+        for (u32 a = 0; a < 3; ++a) {
+            const Bounds& axis = centroidBounds.AxisBounds(a);
+            p[a] = axis.Size() > 0.0f ? std::clamp((centroid[a] - axis.min) / axis.Size(), 0.0f, 1.0f) : 0.5f;
+        }
+
+        if (mortonBits <= 30) {
+            auto Quantize = [](f32 x) { return static_cast<u32>(x * 1023.0f); };
+            return (ExpandBits10(Quantize(p[0])) << 2) | (ExpandBits10(Quantize(p[1])) << 1) | ExpandBits10(Quantize(p[2]));
+        }
+
+        auto Quantize = [](f32 x) { return static_cast<u64>(static_cast<f64>(x) * 2097151.0); };
+        return (ExpandBits21(Quantize(p[0])) << 2) | (ExpandBits21(Quantize(p[1])) << 1) | ExpandBits21(Quantize(p[2]));
+    }
+
+    BVHBuildResult BVHBuilder::BuildLBVH(const std::vector<AABB>& primitiveBounds, const BVH::Config& config)
+    {
+        BVHBuildResult result;
+        if (primitiveBounds.empty()) return result;
+
+        u32 nPrimitives = static_cast<u32>(primitiveBounds.size());
+
+        u32 chunks = (nPrimitives + s_ParallelChunkSize - 1) / s_ParallelChunkSize;
+        std::vector<AABB> partialBounds(chunks);
+
+        JobContext context;
+        JobSystem::Dispatch(context, chunks, 1, [&](JobDispatchArgs args) {
+            u32 first = args.jobIndex * s_ParallelChunkSize;
+            u32 last = std::min(first + s_ParallelChunkSize, nPrimitives);
+            for (u32 i = first; i < last; ++i) {
+                glm::vec3 centroid = primitiveBounds[i].Centroid();
+                partialBounds[args.jobIndex] = AABB(partialBounds[args.jobIndex], AABB(centroid, centroid));
+            }
+        });
+        JobSystem::Wait(context);
+
+        AABB centroidBounds;
+        for (const AABB& bounds : partialBounds) {
+            centroidBounds = AABB(centroidBounds, bounds);
+        }
+
+        u32 mortonBits = config.mortonBits <= 30 ? 30 : 63;
+
+        LBVHBuildState state { config };
+        state.primitives.resize(nPrimitives);
+        JobSystem::Dispatch(context, nPrimitives, s_ParallelChunkSize, [&](JobDispatchArgs args) {
+            u32 i = args.jobIndex;
+            state.primitives[i] = { MortonCode(primitiveBounds[i].Centroid(), centroidBounds, mortonBits), i };
+        });
+        JobSystem::Wait(context);
+
+        RadixSort(state.primitives, mortonBits);
+
+        state.leafOffset = nPrimitives - 1;
+        state.nodes.resize(2 * nPrimitives - 1);
+
+        JobSystem::Dispatch(context, nPrimitives, s_ParallelChunkSize, [&](JobDispatchArgs args) {
+            u32 i = args.jobIndex;
+            if (i + 1 < nPrimitives) {
+                EmitInternalNode(state, static_cast<i32>(i));
+            }
+
+            LBVHNode& leaf = state.nodes[state.leafOffset + i];
+            leaf.bounds = primitiveBounds[state.primitives[i].index];
+            leaf.nPrimitives = 1;
+            leaf.subtreeSize = 1;
+            leaf.cost = LeafCost(state, leaf.bounds, 1);
+        });
+        JobSystem::Wait(context);
+
+        u32 root = nPrimitives > 1 ? 0 : state.leafOffset;
+        ComputeLBVHBounds(state, root);
+
+        if (config.optimizeTreelets) {
+            OptimizeTreelets(state, root);
+        }
+
+        LimitLBVHDepth(state, root, 0);
+
+        result.nodes.resize(state.nodes[root].subtreeSize);
+        state.primitiveIndices.resize(nPrimitives);
+
+        EmitLBVH(state, root, result.nodes, 0, 0);
+
+        result.primitiveIndices = std::move(state.primitiveIndices);
+
+        return result;
+    }
+
+    BVHMetrics BVHBuilder::ComputeMetrics(const std::vector<LinearBVHNode>& nodes, const BVH::Config& config)
+    {
+        BVHMetrics metrics;
+        if (nodes.empty()) return metrics;
+
+        metrics.totalNodes = static_cast<u32>(nodes.size());
+
+        f32 rootArea = nodes[0].bounds.SurfaceArea();
+        f32 invRootArea = rootArea > 0.0f ? 1.0f / rootArea : 0.0f;
+
+        std::vector<std::pair<u32, u32>> stack;
+        stack.emplace_back(0, 0);
+
+        while (!stack.empty()) {
+            auto [index, depth] = stack.back();
+            stack.pop_back();
+
+            const LinearBVHNode& node = nodes[index];
+            f32 relativeArea = node.bounds.SurfaceArea() * invRootArea;
+
+            metrics.maxDepth = std::max(metrics.maxDepth, depth);
+
+            if (node.nPrimitives > 0) {
+                metrics.totalLeaves++;
+                metrics.sahCost += config.intersectionCost * LeafTests(config, node.nPrimitives) * relativeArea;
+            } else {
+                metrics.sahCost += config.traversalCost * relativeArea;
+                stack.emplace_back(index + 1, depth + 1);
+                stack.emplace_back(node.secondChildOffset, depth + 1);
+            }
+        }
+
+        return metrics;
+    }
+
+}
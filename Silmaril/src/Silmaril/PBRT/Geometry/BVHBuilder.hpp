@@ -0,0 +1,47 @@
+#pragma once
+
+#include "BVH.hpp"
+
+namespace Silmaril {
+
+    struct BVHBuildResult
+    {
+        std::vector<LinearBVHNode> nodes;
+        // Spatial splits may reference a primitive from several leaves
+        std::vector<u32> primitiveIndices;
+        u32 spatialSplits { 0 };
+    };
+
+    struct BVHMetrics
+    {
+        u32 totalNodes { 0 };
+        u32 totalLeaves { 0 };
+        u32 maxDepth { 0 };
+        f32 sahCost { 0.0f };
+    };
+
+    class BVHBuilder
+    {
+    public:
+        // Bounds of primitive index clipped to a box
+        using ClipBoundFn = std::function<AABB(u32, const AABB&)>;
+
+    public:
+        static BVHBuildResult BuildSAH(const std::vector<AABB>& primitiveBounds, const BVH::Config& config);
+        static BVHBuildResult BuildLBVH(const std::vector<AABB>& primitiveBounds, const BVH::Config& config);
+        static BVHBuildResult BuildSBVH(const std::vector<AABB>& primitiveBounds, const ClipBoundFn& clipBound, const BVH::Config& config);
+
+        // Morton code of a centroid normalized to the centroid bounds, 30 bits or, when more are asked for, 63 bits
+        static u64 MortonCode(const glm::vec3& centroid, const AABB& centroidBounds, u32 mortonBits);
+
+        static BVHMetrics ComputeMetrics(const std::vector<LinearBVHNode>& nodes, const BVH::Config& config);
+
+        // Intersection tests a leaf of nPrimitives costs, a batch of triangles is tested at once
+        inline static u32 LeafTests(const BVH::Config& config, u32 nPrimitives)
+        {
+            u32 width = std::max(config.triangleBatchWidth, 1u);
+            return (nPrimitives + width - 1) / width;
+        }
+    };
+
+}
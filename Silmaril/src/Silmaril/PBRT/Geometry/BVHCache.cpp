@@ -0,0 +1,220 @@
+#include "BVHCache.hpp"
+
+#include "Silmaril/Core/Logger.hpp"
+#include "Silmaril/Core/MappedFile.hpp"
+
+#include "PathConfig.inl"
+
+namespace Silmaril {
+
+    namespace {
+
+        std::filesystem::path s_CachePath(PathConfig::CacheDir);
+
+        struct BVHCacheHeader
+        {
+            u32 magic;
+            u32 version;
+            u64 key;
+            u32 primitiveCount;
+            u32 nodeCount;
+            u32 referenceCount;
+            u32 spatialSplits;
+        };
+
+        static_assert(std::is_trivially_copyable_v<LinearBVHNode>);
+
+        // FNV-1a
+        class Hasher
+        {
+        public:
+            template <typename T>
+            inline void Add(const T& value)
+            {
+                AddBytes(&value, sizeof(T));
+            }
+
+            inline void AddBytes(const void* data, usize size)
+            {
+                const u8* bytes = static_cast<const u8*>(data);
+                for (usize i = 0; i < size; ++i) {
+                    m_Hash = (m_Hash ^ bytes[i]) * 0x100000001b3ull;
+                }
+            }
+
+            inline u64 Get() const { return m_Hash; }
+
+        private:
+            u64 m_Hash { 0xcbf29ce484222325ull };
+        };
+
+        bool ValidateHierarchy(const BVHBuildResult& build, u32 primitiveCount)
+        {
+            u32 nNodes = static_cast<u32>(build.nodes.size());
+            u32 nReferences = static_cast<u32>(build.primitiveIndices.size());
+
+            for (u32 i = 0; i < nNodes; ++i) {
+                const LinearBVHNode& node = build.nodes[i];
+                if (node.nPrimitives > 0) {
+                    if (static_cast<u64>(node.primitivesOffset) + node.nPrimitives > nReferences) return false;
+                } else if (node.secondChildOffset <= i + 1 || node.secondChildOffset >= nNodes) {
+                    return false;
+                }
+            }
+
+            for (u32 index : build.primitiveIndices) {
+                if (index >= primitiveCount) return false;
+            }
+
+            return true;
+        }
+
+    }
+
+    bool BVHCache::IsCacheable(const BVH::Config& config, const PositionsFn& positions)
+    {
+        return config.strategy != BVH::Strategy::SBVH || positions;
+    }
+
+    u64 BVHCache::ComputeKey(const std::vector<AABB>& primitiveBounds, const PositionsFn& positions, const BVH::Config& config)
+    {
+        assert(IsCacheable(config, positions));
+
+        Hasher hasher;
+        hasher.Add(s_Version);
+        hasher.Add(static_cast<u64>(primitiveBounds.size()));
+
+        for (const AABB& bounds : primitiveBounds) {
+            hasher.Add(bounds.x.min);
+            hasher.Add(bounds.x.max);
+            hasher.Add(bounds.y.min);
+            hasher.Add(bounds.y.max);
+            hasher.Add(bounds.z.min);
+            hasher.Add(bounds.z.max);
+        }
+
+        if (config.strategy == BVH::Strategy::SBVH) {
+            for (u32 i = 0; i < static_cast<u32>(primitiveBounds.size()); ++i) {
+                for (const glm::vec3& p : positions(i)) {
+                    hasher.Add(p.x);
+                    hasher.Add(p.y);
+                    hasher.Add(p.z);
+                }
+            }
+        }
+
+        // The layout is derived from the cached binary hierarchy after loading and stays out of the key
+        hasher.Add(static_cast<u8>(config.strategy));
+        hasher.Add(config.bins);
+        hasher.Add(config.traversalCost);
+        hasher.Add(config.intersectionCost);
+        hasher.Add(config.maxPrimitivesInLeaf);
+        hasher.Add(config.triangleBatchWidth);
+        hasher.Add(config.spatialSplitOverlap);
+        hasher.Add(config.maxDuplication);
+        hasher.Add(config.mortonBits);
+        hasher.Add(static_cast<u8>(config.optimizeTreelets));
+
+        return hasher.Get();
+    }
+
+    std::filesystem::path BVHCache::GetPath(u64 key)
+    {
+        std::array<char, 17> name {};
+        std::to_chars(name.data(), name.data() + 16, key, 16);
+
+        return s_CachePath / (std::string(name.data()) + ".bvh");
+    }
+
+    std::optional<BVHBuildResult> BVHCache::Load(u64 key, u32 primitiveCount)
+    {
+        std::filesystem::path path = GetPath(key);
+
+        auto file = MappedFile::Open(path);
+        if (!file) return std::nullopt;
+
+        const u8* data = file->GetData();
+        usize size = file->GetSize();
+
+        BVHCacheHeader header;
+        if (size < sizeof(header)) return std::nullopt;
+        std::memcpy(&header, data, sizeof(header));
+
+        if (header.magic != s_Magic || header.version != s_Version || header.key != key || header.primitiveCount != primitiveCount) {
+            LOG_WARN("Ignoring stale BVH cache {}", path.string());
+            return std::nullopt;
+        }
+
+        usize nodeBytes = static_cast<usize>(header.nodeCount) * sizeof(LinearBVHNode);
+        usize indexBytes = static_cast<usize>(header.referenceCount) * sizeof(u32);
+        if (header.nodeCount == 0 || size != sizeof(header) + nodeBytes + indexBytes) {
+            LOG_WARN("Ignoring truncated BVH cache {}", path.string());
+            return std::nullopt;
+        }
+
+        BVHBuildResult build;
+        build.nodes.resize(header.nodeCount);
+        build.primitiveIndices.resize(header.referenceCount);
+        build.spatialSplits = header.spatialSplits;
+
+        std::memcpy(build.nodes.data(), data + sizeof(header), nodeBytes);
+        std::memcpy(build.primitiveIndices.data(), data + sizeof(header) + nodeBytes, indexBytes);
+
+        if (!ValidateHierarchy(build, primitiveCount)) {
+            LOG_WARN("Ignoring corrupt BVH cache {}", path.string());
+            return std::nullopt;
+        }
+
+        return build;
+    }
+
+    bool BVHCache::Store(u64 key, u32 primitiveCount, const BVHBuildResult& build)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(s_CachePath, error);
+
+        BVHCacheHeader header {
+            .magic = s_Magic,
+            .version = s_Version,
+            .key = key,
+            .primitiveCount = primitiveCount,
+            .nodeCount = static_cast<u32>(build.nodes.size()),
+            .referenceCount = static_cast<u32>(build.primitiveIndices.size()),
+            .spatialSplits = build.spatialSplits
+        };
+
+        // Written next to the target and renamed over it, so concurrent processes never map a partial file
+        std::filesystem::path path = GetPath(key);
+        std::filesystem::path temporary = path;
+        temporary += "." + std::to_string(std::random_device{}()) + ".tmp";
+
+        {
+            std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+            if (!out) {
+                LOG_WARN("Failed to write BVH cache {}", path.string());
+                return false;
+            }
+
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(build.nodes.data()), build.nodes.size() * sizeof(LinearBVHNode));
+            out.write(reinterpret_cast<const char*>(build.primitiveIndices.data()), build.primitiveIndices.size() * sizeof(u32));
+
+            if (!out) {
+                out.close();
+                std::filesystem::remove(temporary, error);
+                LOG_WARN("Failed to write BVH cache {}", path.string());
+                return false;
+            }
+        }
+
+        std::filesystem::rename(temporary, path, error);
+        if (error) {
+            std::filesystem::remove(temporary, error);
+            LOG_WARN("Failed to write BVH cache {}", path.string());
+            return false;
+        }
+
+        return true;
+    }
+
+}
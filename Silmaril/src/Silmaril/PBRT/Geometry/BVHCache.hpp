@@ -0,0 +1,32 @@
+#pragma once
+
+#include "BVHBuilder.hpp"
+#include "Triangle.hpp"
+
+namespace Silmaril {
+
+    // Versioned binary cache of built hierarchies, one file per key:
+    // header, LinearBVHNode[nodeCount], u32 primitiveIndices[referenceCount].
+    // Bump s_Version whenever LinearBVHNode or a builder changes its output.
+    class BVHCache
+    {
+    public:
+        // Vertices of primitive index, SBVH clips the triangles themselves so equal bounds do not mean equal splits
+        using PositionsFn = std::function<TrianglePositions(u32)>;
+
+        // Hash of the primitive bounds the builders consume and every setting that changes the built hierarchy.
+        // SBVH keys also hash the vertex positions, so SBVH hierarchies are only cached when positions is given.
+        static bool IsCacheable(const BVH::Config& config, const PositionsFn& positions);
+        static u64 ComputeKey(const std::vector<AABB>& primitiveBounds, const PositionsFn& positions, const BVH::Config& config);
+
+        static std::filesystem::path GetPath(u64 key);
+
+        static std::optional<BVHBuildResult> Load(u64 key, u32 primitiveCount);
+        static bool Store(u64 key, u32 primitiveCount, const BVHBuildResult& build);
+
+    private:
+        inline static constexpr u32 s_Magic = 0x48564253; // "SBVH"
+        inline static constexpr u32 s_Version = 2;
+    };
+
+}
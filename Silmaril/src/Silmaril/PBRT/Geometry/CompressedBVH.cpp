@@ -0,0 +1,181 @@
+#include "CompressedBVH.hpp"
+#include "BVH.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        constexpr i32 s_MinExponent = -126;
+        constexpr i32 s_MaxExponent = 127;
+        constexpr u32 s_QuantizedMax = 255;
+
+        struct QuantizedRange
+        {
+            u8 min;
+            u8 max;
+        };
+
+        // Grid of 2^e cells from origin; child minima round down and maxima round up so decoded
+        // bounds always contain the originals. The decode check mirrors the float math of traversal.
+        template <u32 N>
+        i8 QuantizeAxis(f32 origin, f32 extent, const std::array<Bounds, N>& children, u32 count, std::array<QuantizedRange, N>& ranges)
+        {
+            i32 exponent = s_MinExponent;
+            if (extent > 0.0f) {
+                exponent = std::clamp(static_cast<i32>(std::ceil(std::log2(extent / s_QuantizedMax))), s_MinExponent, s_MaxExponent);
+            }
+
+            while (true) {
+                f32 scale = CompressedBVH::ExponentScale(static_cast<i8>(exponent));
+                bool fits = true;
+
+                for (u32 i = 0; i < count && fits; ++i) {
+                    i64 qMin = static_cast<i64>(std::floor((children[i].min - origin) / scale));
+                    i64 qMax = static_cast<i64>(std::ceil((children[i].max - origin) / scale));
+
+                    qMin = std::max<i64>(qMin, 0);
+                    while (qMin > 0 && origin + static_cast<f32>(qMin) * scale > children[i].min) qMin--;
+                    while (qMax <= s_QuantizedMax && origin + static_cast<f32>(qMax) * scale < children[i].max) qMax++;
+
+                    if (qMax > s_QuantizedMax) {
+                        fits = false;
+                        break;
+                    }
+
+                    ranges[i] = { static_cast<u8>(qMin), static_cast<u8>(std::max<i64>(qMax, qMin)) };
+                }
+
+                if (fits || exponent == s_MaxExponent) break;
+                exponent++;
+            }
+
+            return static_cast<i8>(exponent);
+        }
+
+        template <u32 N>
+        struct CompressState
+        {
+            std::vector<LinearBVHNode>& nodes;
+            std::vector<CompressedBVHNode<N>>& compressedNodes;
+            std::vector<u32>& primitiveIndices;
+        };
+
+        template <u32 N>
+        void CompressRecursive(CompressState<N>& state, u32 binaryIndex, u32 compressedIndex)
+        {
+            std::array<u32, N> candidates;
+            u32 count = 0;
+
+            const LinearBVHNode& root = state.nodes[binaryIndex];
+            if (root.nPrimitives > 0) {
+                candidates[count++] = binaryIndex;
+            } else {
+                candidates[count++] = binaryIndex + 1;
+                candidates[count++] = root.secondChildOffset;
+            }
+
+            // Same opening heuristic as the uncompressed collapse
+            while (count < N) {
+                i32 best = -1;
+                f32 bestArea = -1.0f;
+
+                for (u32 i = 0; i < count; ++i) {
+                    const LinearBVHNode& candidate = state.nodes[candidates[i]];
+                    if (candidate.nPrimitives > 0) continue;
+
+                    f32 area = candidate.bounds.SurfaceArea();
+                    if (area > bestArea) {
+                        bestArea = area;
+                        best = static_cast<i32>(i);
+                    }
+                }
+
+                if (best < 0) break;
+
+                u32 opened = candidates[best];
+                candidates[best] = opened + 1;
+                candidates[count++] = state.nodes[opened].secondChildOffset;
+            }
+
+            CompressedBVHNode<N> node {};
+            node.childBase = static_cast<u32>(state.compressedNodes.size());
+            node.primitiveBase = static_cast<u32>(state.primitiveIndices.size());
+
+            // Interior children are allocated as one contiguous block before recursing
+            u32 interiorCount = 0;
+            for (u32 i = 0; i < count; ++i) {
+                const LinearBVHNode& child = state.nodes[candidates[i]];
+                if (child.nPrimitives == 0) {
+                    node.interiorMask |= static_cast<u8>(1u << i);
+                    interiorCount++;
+                    continue;
+                }
+
+                // Regroup leaf primitives so this node's leaves are contiguous, the binary leaf follows along
+                LinearBVHNode& leaf = state.nodes[candidates[i]];
+                u32 newOffset = static_cast<u32>(state.primitiveIndices.size());
+                for (u32 p = 0; p < leaf.nPrimitives; ++p) {
+                    state.primitiveIndices.push_back(leaf.primitivesOffset + p);
+                }
+                leaf.primitivesOffset = newOffset;
+                node.nPrimitives[i] = static_cast<u8>(leaf.nPrimitives);
+            }
+            state.compressedNodes.resize(state.compressedNodes.size() + interiorCount);
+
+            AABB parent;
+            std::array<std::array<Bounds, N>, 3> childBounds;
+            for (u32 i = 0; i < count; ++i) {
+                const AABB& bounds = state.nodes[candidates[i]].bounds;
+                parent = (i == 0) ? bounds : AABB(parent, bounds);
+                for (u32 a = 0; a < 3; ++a) {
+                    childBounds[a][i] = bounds.AxisBounds(a);
+                }
+            }
+
+            std::array<std::array<QuantizedRange, N>, 3> ranges;
+            u8* qMin[3] = { node.qMinX, node.qMinY, node.qMinZ };
+            u8* qMax[3] = { node.qMaxX, node.qMaxY, node.qMaxZ };
+
+            for (u32 a = 0; a < 3; ++a) {
+                const Bounds& axis = parent.AxisBounds(a);
+                node.origin[a] = axis.min;
+                node.exponent[a] = QuantizeAxis<N>(axis.min, axis.Size(), childBounds[a], count, ranges[a]);
+
+                for (u32 i = 0; i < N; ++i) {
+                    // Empty slots decode to inverted bounds, traversal also skips them by their zero count
+                    qMin[a][i] = (i < count) ? ranges[a][i].min : static_cast<u8>(s_QuantizedMax);
+                    qMax[a][i] = (i < count) ? ranges[a][i].max : 0;
+                }
+            }
+
+            state.compressedNodes[compressedIndex] = node;
+
+            u32 childIndex = node.childBase;
+            for (u32 i = 0; i < count; ++i) {
+                if (node.interiorMask & (1u << i)) {
+                    CompressRecursive<N>(state, candidates[i], childIndex++);
+                }
+            }
+        }
+
+    }
+
+    template <u32 N>
+    CompressedBVHResult<N> CompressedBVH::Compress(std::vector<LinearBVHNode>& nodes)
+    {
+        CompressedBVHResult<N> result;
+        if (nodes.empty()) return result;
+
+        result.nodes.reserve(nodes.size() / (N - 1) + 1);
+        result.nodes.emplace_back();
+
+        CompressState<N> state { nodes, result.nodes, result.primitiveIndices };
+        CompressRecursive<N>(state, 0, 0);
+
+        return result;
+    }
+
+    template CompressedBVHResult<4> CompressedBVH::Compress<4>(std::vector<LinearBVHNode>& nodes);
+    template CompressedBVHResult<8> CompressedBVH::Compress<8>(std::vector<LinearBVHNode>& nodes);
+
+}
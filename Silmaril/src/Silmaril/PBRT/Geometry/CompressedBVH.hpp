@@ -0,0 +1,190 @@
+#pragma once
+
+#include "WideBVH.hpp"
+
+namespace Silmaril {
+
+    // N-wide node with child bounds quantized to 8 bits on a power-of-two grid anchored at the node origin.
+    // Interior children are stored contiguously from childBase, leaf primitives contiguously from
+    // primitiveBase in slot order, so a slot only needs its primitive count (0 for interior and empty slots).
+    template <u32 N>
+    struct CompressedBVHNode
+    {
+        f32 origin[3];
+        i8 exponent[3];
+        u8 interiorMask;
+
+        u32 childBase;
+        u32 primitiveBase;
+
+        u8 nPrimitives[N];
+
+        u8 qMinX[N];
+        u8 qMaxX[N];
+        u8 qMinY[N];
+        u8 qMaxY[N];
+        u8 qMinZ[N];
+        u8 qMaxZ[N];
+    };
+
+    using CompressedBVH4Node = CompressedBVHNode<4>;
+    using CompressedBVH8Node = CompressedBVHNode<8>;
+
+    template <u32 N>
+    struct CompressedBVHResult
+    {
+        std::vector<CompressedBVHNode<N>> nodes;
+
+        // New primitive order, indexing the order the binary nodes referenced before compression
+        std::vector<u32> primitiveIndices;
+    };
+
+    class CompressedBVH
+    {
+    public:
+        // Leaf primitives are regrouped per wide node, the binary leaves are remapped to the new order
+        template <u32 N>
+        static CompressedBVHResult<N> Compress(std::vector<LinearBVHNode>& nodes);
+
+        template <u32 N>
+        static u32 IntersectChildren(const CompressedBVHNode<N>& node, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear);
+
+        inline static f32 ExponentScale(i8 exponent)
+        {
+            return std::bit_cast<f32>(static_cast<u32>(exponent + 127) << 23);
+        }
+    };
+
+    namespace CompressedBVHDetail {
+
+        struct DecodedAxis
+        {
+            const u8* qNear;
+            const u8* qFar;
+            f32 origin;
+            f32 scale;
+        };
+
+        template <u32 N>
+        inline std::array<DecodedAxis, 3> SelectPlanes(const CompressedBVHNode<N>& node, const WideBVHRay& ray)
+        {
+            return {{
+                { ray.dirIsNeg[0] ? node.qMaxX : node.qMinX, ray.dirIsNeg[0] ? node.qMinX : node.qMaxX, node.origin[0], CompressedBVH::ExponentScale(node.exponent[0]) },
+                { ray.dirIsNeg[1] ? node.qMaxY : node.qMinY, ray.dirIsNeg[1] ? node.qMinY : node.qMaxY, node.origin[1], CompressedBVH::ExponentScale(node.exponent[1]) },
+                { ray.dirIsNeg[2] ? node.qMaxZ : node.qMinZ, ray.dirIsNeg[2] ? node.qMinZ : node.qMaxZ, node.origin[2], CompressedBVH::ExponentScale(node.exponent[2]) }
+            }};
+        }
+
+        inline u32 IntersectChildrenScalar(u32 count, const std::array<DecodedAxis, 3>& axes, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear)
+        {
+            u32 mask = 0;
+            for (u32 i = 0; i < count; ++i) {
+                f32 t0 = tMin;
+                f32 t1 = tMax;
+                for (u32 a = 0; a < 3; ++a) {
+                    f32 nearPlane = axes[a].origin + axes[a].qNear[i] * axes[a].scale;
+                    f32 farPlane = axes[a].origin + axes[a].qFar[i] * axes[a].scale;
+                    t0 = std::max(t0, (nearPlane - ray.origin[a]) * ray.invDirection[a]);
+                    t1 = std::min(t1, (farPlane - ray.origin[a]) * ray.invDirection[a]);
+                }
+                tNear[i] = t0;
+                mask |= (t0 <= t1) ? (1u << i) : 0u;
+            }
+            return mask;
+        }
+
+#if defined(SILMARIL_SIMD_SSE)
+        inline __m128 LoadQuantized4(const u8* q)
+        {
+            i32 bits;
+            std::memcpy(&bits, q, sizeof(bits));
+
+            const __m128i zero = _mm_setzero_si128();
+            __m128i words = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero);
+            return _mm_cvtepi32_ps(_mm_unpacklo_epi16(words, zero));
+        }
+
+        inline u32 IntersectChildren4(const std::array<DecodedAxis, 3>& axes, u32 offset, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear)
+        {
+            __m128 t0 = _mm_set1_ps(tMin);
+            __m128 t1 = _mm_set1_ps(tMax);
+
+            for (u32 a = 0; a < 3; ++a) {
+                const __m128 origin = _mm_set1_ps(axes[a].origin);
+                const __m128 scale = _mm_set1_ps(axes[a].scale);
+                const __m128 rayOrigin = _mm_set1_ps(ray.origin[a]);
+                const __m128 invDir = _mm_set1_ps(ray.invDirection[a]);
+
+                // q * scale is exact, so decoding matches the conservative rounding done at build time
+                __m128 nearPlane = _mm_add_ps(origin, _mm_mul_ps(LoadQuantized4(axes[a].qNear + offset), scale));
+                __m128 farPlane = _mm_add_ps(origin, _mm_mul_ps(LoadQuantized4(axes[a].qFar + offset), scale));
+
+                t0 = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(nearPlane, rayOrigin), invDir), t0);
+                t1 = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(farPlane, rayOrigin), invDir), t1);
+            }
+
+            _mm_storeu_ps(tNear, t0);
+            return static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(t0, t1)));
+        }
+#endif
+
+#if defined(SILMARIL_SIMD_AVX2)
+        inline __m256 LoadQuantized8(const u8* q)
+        {
+            return _mm256_cvtepi32_ps(_mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(q))));
+        }
+
+        inline u32 IntersectChildren8(const std::array<DecodedAxis, 3>& axes, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear)
+        {
+            __m256 t0 = _mm256_set1_ps(tMin);
+            __m256 t1 = _mm256_set1_ps(tMax);
+
+            for (u32 a = 0; a < 3; ++a) {
+                const __m256 origin = _mm256_set1_ps(axes[a].origin);
+                const __m256 scale = _mm256_set1_ps(axes[a].scale);
+                const __m256 rayOrigin = _mm256_set1_ps(ray.origin[a]);
+                const __m256 invDir = _mm256_set1_ps(ray.invDirection[a]);
+
+                __m256 nearPlane = _mm256_add_ps(origin, _mm256_mul_ps(LoadQuantized8(axes[a].qNear), scale));
+                __m256 farPlane = _mm256_add_ps(origin, _mm256_mul_ps(LoadQuantized8(axes[a].qFar), scale));
+
+                t0 = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(nearPlane, rayOrigin), invDir), t0);
+                t1 = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(farPlane, rayOrigin), invDir), t1);
+            }
+
+            _mm256_storeu_ps(tNear, t0);
+            return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ)));
+        }
+#endif
+
+    }
+
+    template <>
+    inline u32 CompressedBVH::IntersectChildren<4>(const CompressedBVHNode<4>& node, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear)
+    {
+        auto axes = CompressedBVHDetail::SelectPlanes(node, ray);
+
+#if defined(SILMARIL_SIMD_SSE)
+        return CompressedBVHDetail::IntersectChildren4(axes, 0, ray, tMin, tMax, tNear);
+#else
+        return CompressedBVHDetail::IntersectChildrenScalar(4, axes, ray, tMin, tMax, tNear);
+#endif
+    }
+
+    template <>
+    inline u32 CompressedBVH::IntersectChildren<8>(const CompressedBVHNode<8>& node, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear)
+    {
+        auto axes = CompressedBVHDetail::SelectPlanes(node, ray);
+
+#if defined(SILMARIL_SIMD_AVX2)
+        return CompressedBVHDetail::IntersectChildren8(axes, ray, tMin, tMax, tNear);
+#elif defined(SILMARIL_SIMD_SSE)
+        u32 lo = CompressedBVHDetail::IntersectChildren4(axes, 0, ray, tMin, tMax, tNear);
+        u32 hi = CompressedBVHDetail::IntersectChildren4(axes, 4, ray, tMin, tMax, tNear + 4);
+        return lo | (hi << 4);
+#else
+        return CompressedBVHDetail::IntersectChildrenScalar(8, axes, ray, tMin, tMax, tNear);
+#endif
+    }
+
+}
@@ -0,0 +1,284 @@
+#include "CompressedMesh.hpp"
+
+#include "Silmaril/Core/Logger.hpp"
+#include "Silmaril/Core/JobSystem.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        constexpr u32 s_MaxClusterOffset = std::numeric_limits<u16>::max();
+        constexpr f32 s_MaxUV = static_cast<f32>(std::numeric_limits<u16>::max());
+
+        glm::vec2 SignNotZero(const glm::vec2& v)
+        {
+            return glm::vec2(v.x >= 0.0f ? 1.0f : -1.0f, v.y >= 0.0f ? 1.0f : -1.0f);
+        }
+
+        // Unit vector to the [-1, 1] square, the lower hemisphere folds over the diagonals
+        glm::vec2 EncodeOctahedral(const glm::vec3& n)
+        {
+            glm::vec2 p = glm::vec2(n.x, n.y) / (std::abs(n.x) + std::abs(n.y) + std::abs(n.z));
+            if (n.z < 0.0f) {
+                p = (1.0f - glm::abs(glm::vec2(p.y, p.x))) * SignNotZero(p);
+            }
+            return p;
+        }
+
+        glm::vec3 DecodeOctahedral(const glm::vec2& p)
+        {
+            glm::vec3 n(p.x, p.y, 1.0f - std::abs(p.x) - std::abs(p.y));
+            f32 t = std::max(-n.z, 0.0f);
+            n.x += n.x >= 0.0f ? -t : t;
+            n.y += n.y >= 0.0f ? -t : t;
+            return glm::normalize(n);
+        }
+
+        // Tries the four grid points around the encoding and keeps the one decoding closest to n
+        glm::uvec2 QuantizeNormal(const glm::vec3& n, f32 maxValue)
+        {
+            glm::vec3 unit = glm::dot(n, n) > 0.0f ? glm::normalize(n) : glm::vec3(0.0f, 0.0f, 1.0f);
+            glm::vec2 scaled = (EncodeOctahedral(unit) * 0.5f + 0.5f) * maxValue;
+            glm::vec2 base = glm::floor(scaled);
+
+            glm::uvec2 best(0);
+            f32 bestError = std::numeric_limits<f32>::infinity();
+            for (u32 corner = 0; corner < 4; ++corner) {
+                glm::vec2 q = glm::clamp(base + glm::vec2(corner & 1, corner >> 1), glm::vec2(0.0f), glm::vec2(maxValue));
+                f32 error = 1.0f - glm::dot(unit, DecodeOctahedral(q / maxValue * 2.0f - 1.0f));
+                if (error < bestError) {
+                    bestError = error;
+                    best = glm::uvec2(q);
+                }
+            }
+
+            return best;
+        }
+
+        struct ClusterBuild
+        {
+            // Mesh vertices of the cluster, sorted so local indices are found by binary search
+            std::vector<u32> vertices;
+            glm::ivec3 gridMin;
+            glm::vec2 uvMin;
+            glm::vec2 uvMax;
+            bool wide;
+        };
+
+    }
+
+    CompressedMesh::CompressedMesh(const Mesh& mesh, const Config& config)
+        : m_Config(config)
+    {
+        auto compressStart = std::chrono::steady_clock::now();
+
+        m_TriangleCount = static_cast<u32>(mesh.indices.size() / 3);
+        m_HasNormals = !mesh.n.empty();
+        m_HasUVs = !mesh.uv.empty();
+
+        const u32 positionBits = std::clamp(config.positionBits, 8u, 24u);
+        const u32 normalComponentBits = config.normalBits >= 32 ? 16 : 8;
+        const f32 maxNormal = static_cast<f32>((1u << normalComponentBits) - 1);
+
+        AABB bounds;
+        for (const glm::vec3& p : mesh.p) {
+            bounds = AABB(bounds, AABB(p, p));
+        }
+
+        if (!mesh.p.empty()) {
+            m_Origin = glm::vec3(bounds.x.min, bounds.y.min, bounds.z.min);
+
+            // Smallest power of two step that covers the largest extent in 2^positionBits cells
+            f32 extent = std::max({ bounds.x.Size(), bounds.y.Size(), bounds.z.Size() });
+            i32 exponent = 0;
+            std::frexp(std::max(extent, std::numeric_limits<f32>::min()), &exponent);
+            m_Step = std::ldexp(1.0f, exponent - static_cast<i32>(positionBits));
+        }
+
+        const u32 nVertices = static_cast<u32>(mesh.p.size());
+        const i32 maxGrid = 1 << positionBits;
+
+        std::vector<glm::ivec3> grid(nVertices);
+        JobContext context;
+        JobSystem::Dispatch(context, nVertices, 4096, [&](JobDispatchArgs args) {
+            glm::vec3 cell = glm::round((mesh.p[args.jobIndex] - m_Origin) / m_Step);
+            grid[args.jobIndex] = glm::clamp(glm::ivec3(cell), glm::ivec3(0), glm::ivec3(maxGrid));
+        });
+        JobSystem::Wait(context);
+
+        const u32 nClusters = (m_TriangleCount + s_ClusterTriangles - 1) / s_ClusterTriangles;
+        std::vector<ClusterBuild> builds(nClusters);
+
+        JobSystem::Dispatch(context, nClusters, 16, [&](JobDispatchArgs args) {
+            ClusterBuild& build = builds[args.jobIndex];
+
+            u32 first = args.jobIndex * s_ClusterTriangles * 3;
+            u32 last = std::min(first + s_ClusterTriangles * 3, m_TriangleCount * 3);
+
+            build.vertices.assign(mesh.indices.begin() + first, mesh.indices.begin() + last);
+            std::sort(build.vertices.begin(), build.vertices.end());
+            build.vertices.erase(std::unique(build.vertices.begin(), build.vertices.end()), build.vertices.end());
+
+            glm::ivec3 gridMax(std::numeric_limits<i32>::min());
+            build.gridMin = glm::ivec3(std::numeric_limits<i32>::max());
+            build.uvMin = glm::vec2(std::numeric_limits<f32>::max());
+            build.uvMax = glm::vec2(std::numeric_limits<f32>::lowest());
+
+            for (u32 vertex : build.vertices) {
+                build.gridMin = glm::min(build.gridMin, grid[vertex]);
+                gridMax = glm::max(gridMax, grid[vertex]);
+
+                if (m_HasUVs) {
+                    build.uvMin = glm::min(build.uvMin, mesh.uv[vertex]);
+                    build.uvMax = glm::max(build.uvMax, mesh.uv[vertex]);
+                }
+            }
+
+            glm::ivec3 span = gridMax - build.gridMin;
+            build.wide = std::max({ span.x, span.y, span.z }) > static_cast<i32>(s_MaxClusterOffset);
+        });
+        JobSystem::Wait(context);
+
+        m_Clusters.resize(nClusters);
+
+        u32 clusterVertices = 0;
+        u32 positionWords = 0;
+        u32 wideClusters = 0;
+        for (u32 i = 0; i < nClusters; ++i) {
+            const ClusterBuild& build = builds[i];
+            MeshCluster& cluster = m_Clusters[i];
+
+            cluster.base = build.gridMin;
+            cluster.uvMin = m_HasUVs ? build.uvMin : glm::vec2(0.0f);
+            cluster.uvScale = m_HasUVs ? (build.uvMax - build.uvMin) / s_MaxUV : glm::vec2(0.0f);
+            cluster.firstVertex = clusterVertices;
+            cluster.firstPositionWord = positionWords;
+            cluster.wide = build.wide ? 1 : 0;
+
+            u32 count = static_cast<u32>(build.vertices.size());
+            clusterVertices += count;
+            positionWords += count * (build.wide ? 6 : 3);
+            wideClusters += build.wide ? 1 : 0;
+        }
+
+        const u32 normalWords = normalComponentBits == 16 ? 2 : 1;
+
+        m_Indices.resize(m_TriangleCount * 3);
+        m_Positions.resize(positionWords);
+        m_Normals.resize(m_HasNormals ? clusterVertices * normalWords : 0);
+        m_UVs.resize(m_HasUVs ? clusterVertices * 2 : 0);
+
+        JobSystem::Dispatch(context, nClusters, 16, [&](JobDispatchArgs args) {
+            const ClusterBuild& build = builds[args.jobIndex];
+            const MeshCluster& cluster = m_Clusters[args.jobIndex];
+
+            for (u32 local = 0; local < build.vertices.size(); ++local) {
+                u32 vertex = build.vertices[local];
+                u32 clusterVertex = cluster.firstVertex + local;
+
+                glm::uvec3 offset(grid[vertex] - cluster.base);
+                if (cluster.wide) {
+                    u16* words = &m_Positions[cluster.firstPositionWord + local * 6];
+                    for (u32 axis = 0; axis < 3; ++axis) {
+                        words[axis * 2 + 0] = static_cast<u16>(offset[axis] & 0xffff);
+                        words[axis * 2 + 1] = static_cast<u16>(offset[axis] >> 16);
+                    }
+                } else {
+                    u16* words = &m_Positions[cluster.firstPositionWord + local * 3];
+                    words[0] = static_cast<u16>(offset.x);
+                    words[1] = static_cast<u16>(offset.y);
+                    words[2] = static_cast<u16>(offset.z);
+                }
+
+                if (m_HasNormals) {
+                    glm::uvec2 q = QuantizeNormal(mesh.n[vertex], maxNormal);
+                    if (normalWords == 2) {
+                        m_Normals[clusterVertex * 2 + 0] = static_cast<u16>(q.x);
+                        m_Normals[clusterVertex * 2 + 1] = static_cast<u16>(q.y);
+                    } else {
+                        m_Normals[clusterVertex] = static_cast<u16>(q.x | (q.y << 8));
+                    }
+                }
+
+                if (m_HasUVs) {
+                    glm::vec2 uv = mesh.uv[vertex] - cluster.uvMin;
+                    for (u32 axis = 0; axis < 2; ++axis) {
+                        f32 q = cluster.uvScale[axis] > 0.0f ? std::round(uv[axis] / cluster.uvScale[axis]) : 0.0f;
+                        m_UVs[clusterVertex * 2 + axis] = static_cast<u16>(std::clamp(q, 0.0f, s_MaxUV));
+                    }
+                }
+            }
+
+            u32 first = args.jobIndex * s_ClusterTriangles * 3;
+            u32 last = std::min(first + s_ClusterTriangles * 3, m_TriangleCount * 3);
+            for (u32 i = first; i < last; ++i) {
+                auto it = std::lower_bound(build.vertices.begin(), build.vertices.end(), mesh.indices[i]);
+                m_Indices[i] = static_cast<u8>(it - build.vertices.begin());
+            }
+        });
+        JobSystem::Wait(context);
+
+        std::chrono::duration<f64, std::milli> compressTime = std::chrono::steady_clock::now() - compressStart;
+
+        f64 sourceBytes = static_cast<f64>(
+            mesh.p.size() * sizeof(glm::vec3) + mesh.n.size() * sizeof(glm::vec3) + mesh.uv.size() * sizeof(glm::vec2) + mesh.indices.size() * sizeof(u32)
+        );
+        f64 compressedBytes = static_cast<f64>(GetByteSize());
+
+        LOG_INFO("Mesh Compression Metrics");
+        LOG_INFO(" - Clusters: {} of {} triangles ({} wide), {:.2f} vertices per triangle (source {:.2f})",
+            nClusters, s_ClusterTriangles, wideClusters, static_cast<f32>(clusterVertices) / std::max(m_TriangleCount, 1u), static_cast<f32>(nVertices) / std::max(m_TriangleCount, 1u));
+        LOG_INFO(" - Position Grid: {} bits, step {:.3e} (max error {:.3e})", positionBits, m_Step, GetPositionError());
+        LOG_INFO(" - Normals: {}-bit octahedral", normalComponentBits * 2);
+        LOG_INFO(" - Memory: {:.2f} MB (source {:.2f} MB, {:.2f}x)", compressedBytes / (1024.0 * 1024.0), sourceBytes / (1024.0 * 1024.0), sourceBytes / std::max(compressedBytes, 1.0));
+        LOG_INFO(" - Compression Time: {:.2f} ms", compressTime.count());
+    }
+
+    glm::vec3 CompressedMesh::DecodeNormal(u32 vertex) const
+    {
+        glm::vec2 q;
+        f32 maxValue;
+        if (m_Config.normalBits >= 32) {
+            q = glm::vec2(m_Normals[vertex * 2 + 0], m_Normals[vertex * 2 + 1]);
+            maxValue = 65535.0f;
+        } else {
+            u16 packed = m_Normals[vertex];
+            q = glm::vec2(packed & 0xff, packed >> 8);
+            maxValue = 255.0f;
+        }
+
+        return DecodeOctahedral(q / maxValue * 2.0f - 1.0f);
+    }
+
+    TriangleVertices CompressedMesh::GetVertices(u32 triangle) const
+    {
+        const MeshCluster& cluster = m_Clusters[triangle / s_ClusterTriangles];
+        const u8* local = &m_Indices[triangle * 3];
+
+        TriangleVertices vertices;
+        vertices.hasNormals = m_HasNormals;
+        vertices.hasUVs = m_HasUVs;
+
+        for (u32 i = 0; i < 3; ++i) {
+            u32 vertex = cluster.firstVertex + local[i];
+
+            vertices.p[i] = DecodePosition(cluster, local[i]);
+            vertices.n[i] = m_HasNormals ? DecodeNormal(vertex) : glm::vec3(0.0f);
+            vertices.uv[i] = m_HasUVs
+                ? cluster.uvMin + glm::vec2(m_UVs[vertex * 2 + 0], m_UVs[vertex * 2 + 1]) * cluster.uvScale
+                : glm::vec2(0.0f);
+        }
+
+        return vertices;
+    }
+
+    usize CompressedMesh::GetByteSize() const
+    {
+        return m_Clusters.size() * sizeof(MeshCluster)
+            + m_Indices.size() * sizeof(u8)
+            + m_Positions.size() * sizeof(u16)
+            + m_Normals.size() * sizeof(u16)
+            + m_UVs.size() * sizeof(u16);
+    }
+
+}
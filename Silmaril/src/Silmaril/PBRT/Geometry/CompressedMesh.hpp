@@ -0,0 +1,98 @@
+#pragma once
+
+#include "Triangle.hpp"
+
+namespace Silmaril {
+
+    // Consecutive triangles sharing one quantization frame and a local vertex list
+    struct MeshCluster
+    {
+        // Grid coordinates of the cluster's minimum corner, vertex positions are offsets from it
+        glm::ivec3 base;
+
+        glm::vec2 uvMin;
+        glm::vec2 uvScale;
+
+        u32 firstVertex;
+        // Clusters wider than 16 bits on the grid, usually a few huge triangles, store 32-bit offsets
+        u32 firstPositionWord;
+        u8 wide;
+    };
+
+    // Mesh attributes quantized for memory: positions snap to one power-of-two grid over the whole mesh and are
+    // stored as 16-bit offsets per cluster, normals are octahedral and uvs are 16-bit per cluster.
+    // Shared vertices decode to the same grid point in every cluster, so the surface stays watertight.
+    class CompressedMesh
+    {
+    public:
+        struct Config
+        {
+            // Grid cells along the largest mesh extent, as a power of two
+            u32 positionBits { 20 };
+            // Octahedral normals in 16 (two 8-bit) or 32 (two 16-bit) bits
+            u32 normalBits { 32 };
+        };
+
+        // Triangles per cluster, small enough for 8-bit local indices
+        inline static constexpr u32 s_ClusterTriangles = 64;
+
+    public:
+        CompressedMesh(const Mesh& mesh, const Config& config);
+
+        inline u32 GetTriangleCount() const { return m_TriangleCount; }
+
+        inline TrianglePositions GetPositions(u32 triangle) const
+        {
+            const MeshCluster& cluster = m_Clusters[triangle / s_ClusterTriangles];
+            const u8* local = &m_Indices[triangle * 3];
+
+            return { DecodePosition(cluster, local[0]), DecodePosition(cluster, local[1]), DecodePosition(cluster, local[2]) };
+        }
+
+        TriangleVertices GetVertices(u32 triangle) const;
+
+        usize GetByteSize() const;
+
+        // Largest distance between a decoded position and its grid cell center
+        inline f32 GetPositionError() const { return m_Step * 0.5f; }
+
+    private:
+        inline glm::vec3 DecodePosition(const MeshCluster& cluster, u32 local) const
+        {
+            glm::ivec3 q = cluster.base;
+            if (cluster.wide) {
+                const u16* words = &m_Positions[cluster.firstPositionWord + local * 6];
+                q += glm::ivec3(
+                    static_cast<i32>(words[0] | (static_cast<u32>(words[1]) << 16)),
+                    static_cast<i32>(words[2] | (static_cast<u32>(words[3]) << 16)),
+                    static_cast<i32>(words[4] | (static_cast<u32>(words[5]) << 16))
+                );
+            } else {
+                const u16* words = &m_Positions[cluster.firstPositionWord + local * 3];
+                q += glm::ivec3(words[0], words[1], words[2]);
+            }
+
+            // The step is a power of two, so every grid point converts exactly before the single rounding of the add
+            return m_Origin + glm::vec3(q) * m_Step;
+        }
+
+        glm::vec3 DecodeNormal(u32 vertex) const;
+
+    private:
+        Config m_Config;
+
+        u32 m_TriangleCount { 0 };
+        glm::vec3 m_Origin { 0.0f };
+        f32 m_Step { 1.0f };
+
+        bool m_HasNormals { false };
+        bool m_HasUVs { false };
+
+        std::vector<MeshCluster> m_Clusters;
+        std::vector<u8> m_Indices;
+        std::vector<u16> m_Positions;
+        std::vector<u16> m_Normals;
+        std::vector<u16> m_UVs;
+    };
+
+}
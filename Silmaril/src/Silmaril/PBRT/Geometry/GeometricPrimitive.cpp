@@ -18,26 +18,37 @@ namespace Silmaril {
         return AABB();
     }
 
+    AABB GeometricPrimitive::GetClippedBound(const AABB& clip) const
+    {
+        if (m_Shape) return m_Shape->GetClippedBound(clip);
+        return AABB();
+    }
+
     bool GeometricPrimitive::Intersect(const Ray& ray, HitInteraction& hit) const
     {
         if (!m_Shape) return false;
 
-        f32 t;
-        if (!m_Shape->Intersect(ray, t, hit.t)) {
+        if (!m_Shape->Intersect(ray, hit)) {
             return false;
         }
 
-        hit.t = t;
         hit.primitive = this;
 
         return true;
     }
 
+    bool GeometricPrimitive::IntersectP(const Ray& ray, f32 tMax) const
+    {
+        return m_Shape && m_Shape->IntersectP(ray, tMax);
+    }
+
     void GeometricPrimitive::FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const
     {
         if (m_Shape) {
-            m_Shape->FillSurfaceInteraction(ray, hit.t, intersection);
+            m_Shape->FillSurfaceInteraction(ray, hit, intersection);
             intersection.primitive = this;
+            intersection.material = m_Material.get();
+            intersection.light = m_Light.get();
         }
     }
 
@@ -16,12 +16,14 @@ namespace Silmaril {
         virtual ~GeometricPrimitive() = default;
 
         virtual AABB GetBound() const override;
+        virtual AABB GetClippedBound(const AABB& clip) const override;
 
         inline virtual const Material* GetMaterial() const override { return m_Material.get(); }
         inline virtual const Light* GetLight() const override { return m_Light.get(); }
 
         virtual bool Intersect(const Ray& ray, HitInteraction& hit) const override;
         virtual void FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const override;
+        virtual bool IntersectP(const Ray& ray, f32 tMax) const override;
 
     private:
         std::shared_ptr<Shape> m_Shape;
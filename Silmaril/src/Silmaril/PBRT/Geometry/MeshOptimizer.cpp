@@ -0,0 +1,104 @@
+#include "MeshOptimizer.hpp"
+
+#include "BVHBuilder.hpp"
+
+#include "Silmaril/Core/JobSystem.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        template <typename T>
+        void Permute(std::vector<T>& values, const std::vector<u32>& remap)
+        {
+            if (values.empty()) return;
+
+            std::vector<T> permuted(values.size());
+            for (usize i = 0; i < values.size(); ++i) {
+                permuted[remap[i]] = values[i];
+            }
+            values = std::move(permuted);
+        }
+
+    }
+
+    void MeshOptimizer::ReorderSpatially(Mesh& mesh)
+    {
+        const u32 nTriangles = static_cast<u32>(mesh.indices.size() / 3);
+        const u32 nVertices = static_cast<u32>(mesh.p.size());
+        if (nTriangles == 0) return;
+
+        std::vector<glm::vec3> centroids(nTriangles);
+        JobContext context;
+        JobSystem::Dispatch(context, nTriangles, 4096, [&](JobDispatchArgs args) {
+            const u32 base = args.jobIndex * 3;
+            centroids[args.jobIndex] = (mesh.p[mesh.indices[base + 0]] + mesh.p[mesh.indices[base + 1]] + mesh.p[mesh.indices[base + 2]]) / 3.0f;
+        });
+        JobSystem::Wait(context);
+
+        AABB centroidBounds;
+        for (const glm::vec3& centroid : centroids) {
+            centroidBounds = AABB(centroidBounds, AABB(centroid, centroid));
+        }
+
+        // Pairs compare by code, then by triangle index, so equal codes keep their original order
+        std::vector<std::pair<u64, u32>> order(nTriangles);
+        JobSystem::Dispatch(context, nTriangles, 4096, [&](JobDispatchArgs args) {
+            order[args.jobIndex] = { BVHBuilder::MortonCode(centroids[args.jobIndex], centroidBounds, 63), args.jobIndex };
+        });
+        JobSystem::Wait(context);
+
+        std::sort(order.begin(), order.end());
+
+        std::vector<u32> indices(mesh.indices.size());
+        std::vector<i32> materials(mesh.materials.empty() ? 0 : nTriangles);
+        for (u32 i = 0; i < nTriangles; ++i) {
+            const u32 triangle = order[i].second;
+            indices[i * 3 + 0] = mesh.indices[triangle * 3 + 0];
+            indices[i * 3 + 1] = mesh.indices[triangle * 3 + 1];
+            indices[i * 3 + 2] = mesh.indices[triangle * 3 + 2];
+
+            if (!materials.empty()) materials[i] = mesh.materials[triangle];
+        }
+
+        // Vertices no triangle references keep their relative order after the used ones
+        constexpr u32 unused = std::numeric_limits<u32>::max();
+        std::vector<u32> remap(nVertices, unused);
+        u32 next = 0;
+        for (u32& index : indices) {
+            if (remap[index] == unused) remap[index] = next++;
+            index = remap[index];
+        }
+        for (u32& slot : remap) {
+            if (slot == unused) slot = next++;
+        }
+
+        Permute(mesh.p, remap);
+        Permute(mesh.n, remap);
+        Permute(mesh.uv, remap);
+
+        mesh.indices = std::move(indices);
+        if (!materials.empty()) mesh.materials = std::move(materials);
+    }
+
+    f64 MeshOptimizer::SimulateCacheMisses(const Mesh& mesh)
+    {
+        const usize nTriangles = mesh.indices.size() / 3;
+        if (nTriangles == 0) return 0.0;
+
+        std::vector<u64> tags(s_CacheLines, std::numeric_limits<u64>::max());
+        u64 misses = 0;
+
+        for (u32 index : mesh.indices) {
+            u64 line = static_cast<u64>(index) * sizeof(glm::vec3) / s_CacheLineBytes;
+            u64& tag = tags[line % s_CacheLines];
+            if (tag != line) {
+                tag = line;
+                ++misses;
+            }
+        }
+
+        return static_cast<f64>(misses) / static_cast<f64>(nTriangles);
+    }
+
+}
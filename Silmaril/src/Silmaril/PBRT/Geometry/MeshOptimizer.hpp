@@ -0,0 +1,23 @@
+#pragma once
+
+#include "Mesh.hpp"
+
+namespace Silmaril {
+
+    // Reorders mesh data for memory locality without changing the surface
+    class MeshOptimizer
+    {
+    public:
+        // Sorts triangles along a Morton curve of their centroids, then renumbers vertices in order of first use,
+        // so triangles that are close in space, and the BVH leaves holding them, read nearby vertex memory
+        static void ReorderSpatially(Mesh& mesh);
+
+        // Position cache lines missed per triangle when the triangles are read in order through a small direct mapped cache
+        static f64 SimulateCacheMisses(const Mesh& mesh);
+
+    private:
+        inline static constexpr u32 s_CacheLineBytes = 64;
+        inline static constexpr u32 s_CacheLines = 512;
+    };
+
+}
@@ -1,40 +1,25 @@
 #include "Model.hpp"
 
-#include "Triangle.hpp"
-#include "GeometricPrimitive.hpp"
-
 #include "Silmaril/PBRT/Materials/MatteMaterial.hpp"
 
 namespace Silmaril {
 
-    std::vector<std::shared_ptr<Primitive>> Model::CreatePrimitives()
+    std::shared_ptr<TriangleMesh> Model::CreateTriangleMesh() const
     {
-        if (!mesh) return {};
-
-        usize triangles = mesh->indices.size() / 3;
-
-        std::vector<std::shared_ptr<Primitive>> primitives;
-        primitives.reserve(triangles);
+        if (!mesh) return nullptr;
 
         auto defaultMaterial = std::make_shared<MatteMaterial>(glm::vec3(0.75f));
 
-        for (u32 i = 0; i < triangles; ++i) {
-            auto triangle = std::make_shared<Triangle>(mesh, i);
-            std::shared_ptr<Material> material = defaultMaterial;
+        return std::make_shared<TriangleMesh>(mesh, materials, emission, defaultMaterial);
+    }
 
-            if (!mesh->materials.empty()) {
-                i32 matIdx = mesh->materials[i];
-                if (matIdx >= 0 && matIdx < static_cast<i32>(materials.size())) {
-                    material = materials[matIdx];
-                }
-            } else if (!materials.empty()) {
-                material = materials[0];
-            }
+    std::shared_ptr<TriangleMesh> Model::CreateTriangleMesh(const CompressedMesh::Config& compression) const
+    {
+        if (!mesh) return nullptr;
 
-            primitives.push_back(std::make_shared<GeometricPrimitive>(triangle, material));
-        }
+        auto defaultMaterial = std::make_shared<MatteMaterial>(glm::vec3(0.75f));
 
-        return primitives;
+        return std::make_shared<TriangleMesh>(*mesh, compression, materials, emission, defaultMaterial);
     }
 
 }
@@ -1,7 +1,6 @@
 #pragma once
 
-#include "Primitive.hpp"
-#include "Mesh.hpp"
+#include "TriangleMesh.hpp"
 
 #include "Silmaril/PBRT/Materials/Material.hpp"
 
@@ -11,8 +10,11 @@ namespace Silmaril {
     {
         std::shared_ptr<Mesh> mesh;
         std::vector<std::shared_ptr<Material>> materials;
+        // Radiance each material emits, parallel to materials
+        std::vector<glm::vec3> emission;
 
-        std::vector<std::shared_ptr<Primitive>> CreatePrimitives();
+        std::shared_ptr<TriangleMesh> CreateTriangleMesh() const;
+        std::shared_ptr<TriangleMesh> CreateTriangleMesh(const CompressedMesh::Config& compression) const;
     };
 
 }
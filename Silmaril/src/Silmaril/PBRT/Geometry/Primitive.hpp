@@ -17,8 +17,17 @@ namespace Silmaril {
         virtual bool Intersect(const Ray& ray, HitInteraction& hit) const = 0;
         virtual void FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const = 0;
 
+        // Occlusion query: true as soon as any hit closer than tMax is found, without searching for the closest one
+        virtual bool IntersectP(const Ray& ray, f32 tMax) const = 0;
+
         virtual AABB GetBound() const = 0;
 
+        // Bounds of the part of the primitive inside clip, used by spatial splits
+        inline virtual AABB GetClippedBound(const AABB& clip) const
+        {
+            return GetBound().Overlap(clip);
+        }
+
         virtual const Material* GetMaterial() const = 0;
         virtual const Light* GetLight() const = 0;
     };
@@ -3,6 +3,7 @@
 #include "Silmaril/PBRT/Containers/Interaction.hpp"
 #include "Silmaril/PBRT/Containers/AABB.hpp"
 #include "Silmaril/PBRT/Containers/Ray.hpp"
+#include "Silmaril/PBRT/Containers/DirectionCone.hpp"
 
 namespace Silmaril {
 
@@ -14,24 +15,73 @@ namespace Silmaril {
         virtual AABB GetBound() const = 0;
         virtual f32 Area() const = 0;
 
-        virtual bool Intersect(const Ray& ray, f32& tHit, f32 tMax) const = 0;
-        virtual void FillSurfaceInteraction(const Ray& ray, f32 tHit, SurfaceInteraction& intersection) const = 0;
+        // Cone holding every surface normal, the whole sphere unless the shape knows better
+        inline virtual DirectionCone NormalBounds() const
+        {
+            return DirectionCone::EntireSphere();
+        }
+
+        inline virtual AABB GetClippedBound(const AABB& clip) const
+        {
+            return GetBound().Overlap(clip);
+        }
 
-        inline virtual bool IntersectP(const Ray& ray) const
+        // Records t and the parametric coordinates when closer than hit.t, the caller fills in the primitive
+        virtual bool Intersect(const Ray& ray, HitInteraction& hit) const = 0;
+        // Only interpolates from what Intersect recorded, nothing is intersected again
+        virtual void FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const = 0;
+
+        inline virtual bool IntersectP(const Ray& ray, f32 tMax = std::numeric_limits<f32>::max()) const
         {
-            f32 t;
-            return Intersect(ray, t, std::numeric_limits<f32>::max());;
+            HitInteraction hit;
+            hit.t = tMax;
+            return Intersect(ray, hit);
         }
 
+        // Uniform over the surface, the pdf is per unit area
         virtual Interaction Sample(const glm::vec2& u, f32& pdf) const = 0;
+
+        // A point as seen from ref, the pdf is per unit solid angle at ref
         virtual Interaction Sample(const Interaction& ref, const glm::vec2& u, f32& pdf) const
         {
-            return Sample(u, pdf);
+            Interaction sample = Sample(u, pdf);
+            pdf = AreaToSolidAngle(ref, sample, pdf);
+
+            return sample;
         }
 
+        // Solid angle density of Sample(ref, ...) at a point on the shape
+        virtual f32 Pdf(const Interaction& ref, const Interaction& sample) const
+        {
+            return AreaToSolidAngle(ref, sample, 1.0f / Area());
+        }
+
+        // Same toward a direction, through the closest intersection with the shape
         virtual f32 Pdf(const Interaction& ref, const glm::vec3& wi) const
         {
-            return 1.0f / Area();
+            Ray ray = ref.SpawnRay(wi);
+            HitInteraction hit;
+
+            if (!Intersect(ray, hit)) return 0.0f;
+
+            SurfaceInteraction intersection;
+            FillSurfaceInteraction(ray, hit, intersection);
+
+            return Pdf(ref, intersection);
+        }
+
+    protected:
+        static f32 AreaToSolidAngle(const Interaction& ref, const Interaction& sample, f32 pdf)
+        {
+            glm::vec3 d = sample.p - ref.p;
+            f32 dist2 = glm::dot(d, d);
+            if (dist2 == 0.0f) return 0.0f;
+
+            // Grazing samples would blow up the density
+            f32 cosTheta = glm::abs(glm::dot(sample.n, d)) / glm::sqrt(dist2);
+            if (cosTheta < 1e-4f) return 0.0f;
+
+            return pdf * dist2 / cosTheta;
         }
     };
 
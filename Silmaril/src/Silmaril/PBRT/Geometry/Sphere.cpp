@@ -4,6 +4,26 @@
 
 namespace Silmaril {
 
+    namespace {
+
+        f32 SafeSqrt(f32 x)
+        {
+            return glm::sqrt(std::max(x, 0.0f));
+        }
+
+        // Orthonormal tangents around a unit vector, branchless as in Duff et al. 2017
+        void CoordinateSystem(const glm::vec3& w, glm::vec3& t, glm::vec3& b)
+        {
+            f32 sign = std::copysign(1.0f, w.z);
+            f32 a = -1.0f / (sign + w.z);
+            f32 c = w.x * w.y * a;
+
+            t = glm::vec3(1.0f + sign * w.x * w.x * a, sign * c, -sign * w.x);
+            b = glm::vec3(c, sign + w.y * w.y * a, -w.y);
+        }
+
+    }
+
     Sphere::Sphere(const glm::vec3& center, f32 radius)
         : m_Center(center), m_Radius(radius)
     {
@@ -19,7 +39,7 @@ namespace Silmaril {
         return 4.0f * glm::pi<f32>() * m_Radius * m_Radius;
     }
 
-    bool Sphere::Intersect(const Ray& ray, f32& tHit, f32 tMax) const
+    bool Sphere::Intersect(const Ray& ray, HitInteraction& hit) const
     {
         glm::vec3 oc = ray.origin - m_Center;
 
@@ -27,28 +47,37 @@ namespace Silmaril {
         f32 b = 2.0f * glm::dot(oc, ray.direction);
         f32 c = glm::dot(oc, oc) - m_Radius * m_Radius;
 
-        f32 discriminant = b * b - 4.0f * a * c;
+        // b^2 - 4ac from the distance between the center and the line, b^2 and 4ac cancel catastrophically
+        // for small spheres far from the ray origin
+        glm::vec3 v = oc - (b / (2.0f * a)) * ray.direction;
+        f32 length = glm::length(v);
+        f32 discriminant = 4.0f * a * (m_Radius + length) * (m_Radius - length);
 
         if (discriminant < 0.0f) return false;
 
         f32 sqrtd = glm::sqrt(discriminant);
-        f32 root = (-b - sqrtd) / (2.0f * a);
+        f32 q = (b < 0.0f) ? -0.5f * (b - sqrtd) : -0.5f * (b + sqrtd);
+
+        f32 t0 = q / a;
+        f32 t1 = c / q;
+        if (t0 > t1) std::swap(t0, t1);
 
-        if (root <= std::numeric_limits<f32>::epsilon() || root > tMax) {
-            root = (-b + sqrtd) / (2.0f * a);
-            if (root <= std::numeric_limits<f32>::epsilon() || root > tMax) {
+        f32 root = t0;
+        if (root <= std::numeric_limits<f32>::epsilon() || root > hit.t) {
+            root = t1;
+            if (root <= std::numeric_limits<f32>::epsilon() || root > hit.t) {
                 return false;
             }
         }
 
-        tHit = root;
+        hit.t = root;
 
         return true;
     }
 
-    void Sphere::FillSurfaceInteraction(const Ray& ray, f32 tHit, SurfaceInteraction& intersection) const
+    void Sphere::FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const
     {
-        glm::vec3 p = ray.At(tHit);
+        glm::vec3 p = ray.At(hit.t);
         glm::vec3 n = (p - m_Center) / m_Radius;
 
         f32 theta = glm::acos(std::clamp(-n.y, -1.0f, 1.0f));
@@ -77,10 +106,10 @@ namespace Silmaril {
         glm::vec3 dndu(dpdu / m_Radius);
         glm::vec3 dndv(dpdv / m_Radius);
 
-        glm::vec3 pError = glm::abs(p) * std::numeric_limits<f32>::max() * 5.0f;
+        glm::vec3 pError = glm::abs(p) * std::numeric_limits<f32>::epsilon() * 5.0f;
 
         intersection = SurfaceInteraction(p, pError, uv, -ray.direction, dpdu, dpdv, dndu, dndv, ray.time, this);
-        intersection.t = tHit;
+        intersection.t = hit.t;
     }
 
     Interaction Sphere::Sample(const glm::vec2& u, f32& pdf) const
@@ -95,14 +124,63 @@ namespace Silmaril {
 
         pdf = 1.0f / Area();
 
-        glm::vec3 pError = glm::abs(p) * std::numeric_limits<f32>::max() * 5.0f;
+        glm::vec3 pError = glm::abs(p) * std::numeric_limits<f32>::epsilon() * 5.0f;
         return Interaction(p, n, pError, glm::vec3(0.0f), 0.0);
     }
 
     Interaction Sphere::Sample(const Interaction& ref, const glm::vec2& u, f32& pdf) const
     {
-        // TODO: Uniform cone sampling
-        return Sample(u, pdf);
+        glm::vec3 toCenter = m_Center - ref.p;
+        f32 dc2 = glm::dot(toCenter, toCenter);
+
+        if (dc2 <= m_Radius * m_Radius) {
+            return Shape::Sample(ref, u, pdf);
+        }
+
+        // Every direction of the cone reaches the near side of the sphere, so no sample lands on the back
+        f32 dc = glm::sqrt(dc2);
+        glm::vec3 wc = toCenter / dc;
+        glm::vec3 wcX;
+        glm::vec3 wcY;
+        CoordinateSystem(wc, wcX, wcY);
+
+        f32 sin2ThetaMax = m_Radius * m_Radius / dc2;
+        f32 sinThetaMax = glm::sqrt(sin2ThetaMax);
+        f32 cosThetaMax = SafeSqrt(1.0f - sin2ThetaMax);
+        // 1 - cosThetaMax without the cancellation, distant lights subtend tiny cones
+        f32 oneMinusCosThetaMax = sin2ThetaMax / (1.0f + cosThetaMax);
+
+        f32 cosTheta = 1.0f - u[0] * oneMinusCosThetaMax;
+        f32 sin2Theta = u[0] * oneMinusCosThetaMax * (1.0f + cosTheta);
+
+        // Angle at the center between -wc and the point whose direction makes theta with wc
+        f32 cosAlpha = sin2Theta / sinThetaMax + cosTheta * SafeSqrt(1.0f - sin2Theta / sin2ThetaMax);
+        f32 sinAlpha = SafeSqrt(1.0f - cosAlpha * cosAlpha);
+        f32 phi = 2.0f * glm::pi<f32>() * u[1];
+
+        glm::vec3 n = -(sinAlpha * glm::cos(phi) * wcX + sinAlpha * glm::sin(phi) * wcY + cosAlpha * wc);
+        glm::vec3 p = m_Center + m_Radius * n;
+
+        pdf = 1.0f / (2.0f * glm::pi<f32>() * oneMinusCosThetaMax);
+
+        glm::vec3 pError = glm::abs(p) * std::numeric_limits<f32>::epsilon() * 5.0f;
+        return Interaction(p, n, pError, glm::vec3(0.0f), ref.time);
+    }
+
+    f32 Sphere::Pdf(const Interaction& ref, const Interaction& sample) const
+    {
+        glm::vec3 toCenter = m_Center - ref.p;
+        f32 dc2 = glm::dot(toCenter, toCenter);
+
+        if (dc2 <= m_Radius * m_Radius) {
+            return Shape::Pdf(ref, sample);
+        }
+
+        f32 sin2ThetaMax = m_Radius * m_Radius / dc2;
+        f32 cosThetaMax = SafeSqrt(1.0f - sin2ThetaMax);
+        f32 oneMinusCosThetaMax = sin2ThetaMax / (1.0f + cosThetaMax);
+
+        return 1.0f / (2.0f * glm::pi<f32>() * oneMinusCosThetaMax);
     }
 
 }
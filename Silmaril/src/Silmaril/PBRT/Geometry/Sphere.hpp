@@ -13,12 +13,16 @@ namespace Silmaril {
         virtual AABB GetBound() const override;
         virtual f32 Area() const override;
 
-        virtual bool Intersect(const Ray& ray, f32& tHit, f32 tMax) const override;
-        virtual void FillSurfaceInteraction(const Ray& ray, f32 tHit, SurfaceInteraction& intersection) const override;
+        virtual bool Intersect(const Ray& ray, HitInteraction& hit) const override;
+        virtual void FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const override;
 
         virtual Interaction Sample(const glm::vec2& u, f32& pdf) const override;
+        // Uniform over the cone of directions the sphere subtends from ref, by area from inside the sphere
         virtual Interaction Sample(const Interaction& ref, const glm::vec2& u, f32& pdf) const override;
 
+        using Shape::Pdf;
+        virtual f32 Pdf(const Interaction& ref, const Interaction& sample) const override;
+
     private:
         glm::vec3 m_Center;
         f32 m_Radius;
@@ -0,0 +1,123 @@
+#include "TransformedPrimitive.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        glm::vec3 TransformPoint(const glm::mat4& m, const glm::vec3& p)
+        {
+            return glm::vec3(m * glm::vec4(p, 1.0f));
+        }
+
+        glm::vec3 TransformVector(const glm::mat4& m, const glm::vec3& v)
+        {
+            return glm::vec3(m * glm::vec4(v, 0.0f));
+        }
+
+        // Conservative world space error of a transformed point: the carried object space error plus the rounding of the transform
+        glm::vec3 TransformError(const glm::mat4& m, const glm::vec3& p, const glm::vec3& pError)
+        {
+            constexpr f32 gamma = std::numeric_limits<f32>::epsilon() * 2.0f;
+
+            glm::vec3 error(0.0f);
+            for (u32 row = 0; row < 3; ++row) {
+                f32 carried = 0.0f;
+                f32 rounding = std::abs(m[3][row]);
+                for (u32 column = 0; column < 3; ++column) {
+                    carried += std::abs(m[column][row]) * pError[column];
+                    rounding += std::abs(m[column][row] * p[column]);
+                }
+                error[row] = (1.0f + gamma) * carried + gamma * rounding;
+            }
+            return error;
+        }
+
+    }
+
+    TransformedPrimitive::TransformedPrimitive(const std::shared_ptr<Primitive>& primitive, const glm::mat4& objectToWorld)
+        : m_Primitive(primitive)
+    {
+        SetTransform(objectToWorld);
+    }
+
+    void TransformedPrimitive::SetTransform(const glm::mat4& objectToWorld)
+    {
+        m_ObjectToWorld = objectToWorld;
+        m_WorldToObject = glm::inverse(objectToWorld);
+        m_NormalToWorld = glm::transpose(glm::mat3(m_WorldToObject));
+
+        m_Bound = AABB();
+        if (!m_Primitive) return;
+
+        AABB bound = m_Primitive->GetBound();
+        if (bound.IsEmpty()) return;
+
+        for (u32 corner = 0; corner < 8; ++corner) {
+            glm::vec3 p(
+                (corner & 1) ? bound.x.max : bound.x.min,
+                (corner & 2) ? bound.y.max : bound.y.min,
+                (corner & 4) ? bound.z.max : bound.z.min
+            );
+
+            glm::vec3 world = TransformPoint(m_ObjectToWorld, p);
+            m_Bound = (corner == 0) ? AABB(world, world) : AABB(m_Bound, AABB(world, world));
+        }
+    }
+
+    Ray TransformedPrimitive::ToObject(const Ray& ray) const
+    {
+        // The direction is left unnormalized so hit distances stay comparable with world space
+        return Ray(TransformPoint(m_WorldToObject, ray.origin), TransformVector(m_WorldToObject, ray.direction), ray.time);
+    }
+
+    bool TransformedPrimitive::Intersect(const Ray& ray, HitInteraction& hit) const
+    {
+        if (!m_Primitive) return false;
+
+        HitInteraction objectHit = hit;
+        if (!m_Primitive->Intersect(ToObject(ray), objectHit)) {
+            return false;
+        }
+
+        hit = objectHit;
+        hit.primitive = this;
+        hit.objectPrimitive = objectHit.primitive;
+
+        return true;
+    }
+
+    bool TransformedPrimitive::IntersectP(const Ray& ray, f32 tMax) const
+    {
+        return m_Primitive && m_Primitive->IntersectP(ToObject(ray), tMax);
+    }
+
+    void TransformedPrimitive::FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const
+    {
+        HitInteraction objectHit = hit;
+        objectHit.primitive = hit.objectPrimitive;
+        objectHit.objectPrimitive = nullptr;
+
+        objectHit.primitive->FillSurfaceInteraction(ToObject(ray), objectHit, intersection);
+
+        intersection.pError = TransformError(m_ObjectToWorld, intersection.p, intersection.pError);
+        intersection.p = TransformPoint(m_ObjectToWorld, intersection.p);
+        intersection.wo = -ray.direction;
+        intersection.n = glm::normalize(m_NormalToWorld * intersection.n);
+
+        intersection.dpdu = TransformVector(m_ObjectToWorld, intersection.dpdu);
+        intersection.dpdv = TransformVector(m_ObjectToWorld, intersection.dpdv);
+        intersection.dndu = m_NormalToWorld * intersection.dndu;
+        intersection.dndv = m_NormalToWorld * intersection.dndv;
+
+        intersection.shading.n = glm::normalize(m_NormalToWorld * intersection.shading.n);
+        intersection.shading.dpdu = TransformVector(m_ObjectToWorld, intersection.shading.dpdu);
+        intersection.shading.dpdv = TransformVector(m_ObjectToWorld, intersection.shading.dpdv);
+        intersection.shading.dndu = m_NormalToWorld * intersection.shading.dndu;
+        intersection.shading.dndv = m_NormalToWorld * intersection.shading.dndv;
+
+        if (m_Light && m_Light->IsEmitter(intersection.triangle)) {
+            intersection.light = m_Light.get();
+        }
+    }
+
+}
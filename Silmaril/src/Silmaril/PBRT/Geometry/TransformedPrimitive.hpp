@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Primitive.hpp"
+
+#include "Silmaril/PBRT/Lights/MeshLight.hpp"
+
+namespace Silmaril {
+
+    // Instance of a shared primitive, usually a bottom-level BVH, placed in the world by a transform.
+    // Rays are moved into object space instead of transforming the geometry, so any number of instances
+    // share one copy of the geometry and its acceleration structure. Instances do not nest.
+    class TransformedPrimitive final : public Primitive
+    {
+    public:
+        TransformedPrimitive(const std::shared_ptr<Primitive>& primitive, const glm::mat4& objectToWorld);
+        virtual ~TransformedPrimitive() = default;
+
+        inline virtual AABB GetBound() const override { return m_Bound; }
+        inline virtual const Material* GetMaterial() const override { return nullptr; }
+        inline virtual const Light* GetLight() const override { return m_Light.get(); }
+
+        virtual bool Intersect(const Ray& ray, HitInteraction& hit) const override;
+        virtual void FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const override;
+        virtual bool IntersectP(const Ray& ray, f32 tMax) const override;
+
+        // Moving an instance only invalidates the top-level BVH, which can be refit afterwards
+        void SetTransform(const glm::mat4& objectToWorld);
+
+        // Emissive triangles of the instanced mesh, hits on them resolve to this light
+        inline void SetLight(const std::shared_ptr<MeshLight>& light) { m_Light = light; }
+
+        inline const std::shared_ptr<Primitive>& GetPrimitive() const { return m_Primitive; }
+        inline const glm::mat4& GetTransform() const { return m_ObjectToWorld; }
+
+    private:
+        Ray ToObject(const Ray& ray) const;
+
+    private:
+        std::shared_ptr<Primitive> m_Primitive;
+        std::shared_ptr<MeshLight> m_Light;
+
+        glm::mat4 m_ObjectToWorld;
+        glm::mat4 m_WorldToObject;
+        glm::mat3 m_NormalToWorld;
+
+        AABB m_Bound;
+    };
+
+}
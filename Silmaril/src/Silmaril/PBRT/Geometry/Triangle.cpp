@@ -5,95 +5,150 @@
 namespace Silmaril {
 
     Triangle::Triangle(const std::shared_ptr<Mesh>& mesh, u32 index)
-        : m_Mesh(mesh), m_Index(index * 3)
+        : m_Mesh(mesh), m_Index(index)
     {
     }
 
     AABB Triangle::GetBound() const
     {
-        const glm::vec3& p0 = m_Mesh->p[m_Mesh->indices[m_Index + 0]];
-        const glm::vec3& p1 = m_Mesh->p[m_Mesh->indices[m_Index + 1]];
-        const glm::vec3& p2 = m_Mesh->p[m_Mesh->indices[m_Index + 2]];
-
-        AABB bbox(p0, p1);
-        bbox = AABB(bbox, AABB(p2, p2));
+        return GetBound(*m_Mesh, m_Index);
+    }
 
-        return bbox;
+    AABB Triangle::GetClippedBound(const AABB& clip) const
+    {
+        return GetClippedBound(*m_Mesh, m_Index, clip);
     }
 
     f32 Triangle::Area() const
     {
-        const u32 idx0 = m_Mesh->indices[m_Index + 0];
-        const u32 idx1 = m_Mesh->indices[m_Index + 1];
-        const u32 idx2 = m_Mesh->indices[m_Index + 2];
-
-        const glm::vec3& p0 = m_Mesh->p[idx0];
-        const glm::vec3& p1 = m_Mesh->p[idx1];
-        const glm::vec3& p2 = m_Mesh->p[idx2];
+        return Area(*m_Mesh, m_Index);
+    }
 
-        return 0.5f * glm::length(glm::cross(p1 - p0, p2 - p0));
+    bool Triangle::Intersect(const Ray& ray, HitInteraction& hit) const
+    {
+        return Intersect(*m_Mesh, m_Index, ray, hit);
     }
 
-    bool Triangle::Intersect(const Ray& ray, f32& tHit, f32 tMax) const
+    void Triangle::FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const
     {
-        const u32 idx0 = m_Mesh->indices[m_Index + 0];
-        const u32 idx1 = m_Mesh->indices[m_Index + 1];
-        const u32 idx2 = m_Mesh->indices[m_Index + 2];
+        FillSurfaceInteraction(*m_Mesh, m_Index, ray, hit, this, intersection);
+    }
 
-        const glm::vec3& p0 = m_Mesh->p[idx0];
-        const glm::vec3& p1 = m_Mesh->p[idx1];
-        const glm::vec3& p2 = m_Mesh->p[idx2];
+    Interaction Triangle::Sample(const glm::vec2& u, f32& pdf) const
+    {
+        return Sample(*m_Mesh, m_Index, u, pdf);
+    }
 
-        glm::vec3 e1 = p1 - p0;
-        glm::vec3 e2 = p2 - p0;
+    TriangleVertices Triangle::GetVertices(const Mesh& mesh, u32 triangle)
+    {
+        const u32 base = triangle * 3;
 
-        glm::vec3 s1 = glm::cross(ray.direction, e2);
-        f32 divisor = glm::dot(s1, e1);
+        TriangleVertices vertices;
+        vertices.hasNormals = !mesh.n.empty();
+        vertices.hasUVs = !mesh.uv.empty();
 
-        if (divisor == 0.0f) return false;
-        f32 invDivisor = 1.0f / divisor;
+        for (u32 i = 0; i < 3; ++i) {
+            const u32 index = mesh.indices[base + i];
 
-        glm::vec3 s = ray.origin - p0;
-        f32 b1 = glm::dot(s, s1) * invDivisor;
-        if (b1 < 0.0f || b1 > 1.0f) return false;
+            vertices.p[i] = mesh.p[index];
+            vertices.n[i] = vertices.hasNormals ? mesh.n[index] : glm::vec3(0.0f);
+            vertices.uv[i] = vertices.hasUVs ? mesh.uv[index] : glm::vec2(0.0f);
+        }
 
-        glm::vec3 s2 = glm::cross(s, e1);
-        f32 b2 = glm::dot(ray.direction, s2) * invDivisor;
-        if (b2 < 0.0f || b1 + b2 > 1.0f) return false;
+        return vertices;
+    }
 
-        f32 t = glm::dot(e2, s2) * invDivisor;
+    AABB Triangle::GetBound(const Mesh& mesh, u32 triangle)
+    {
+        return GetBound(GetPositions(mesh, triangle));
+    }
 
-        if (t < 0.0f) return false;
+    AABB Triangle::GetBound(const TrianglePositions& p)
+    {
+        AABB bbox(p[0], p[1]);
+        bbox = AABB(bbox, AABB(p[2], p[2]));
 
-        tHit = t;
+        return bbox;
+    }
 
-        return true;
+    AABB Triangle::GetClippedBound(const Mesh& mesh, u32 triangle, const AABB& clip)
+    {
+        return GetClippedBound(GetPositions(mesh, triangle), clip);
     }
 
-    void Triangle::FillSurfaceInteraction(const Ray& ray, f32 tHit, SurfaceInteraction& intersection) const
+    AABB Triangle::GetClippedBound(const TrianglePositions& p, const AABB& clip)
     {
-        const u32 idx0 = m_Mesh->indices[m_Index + 0];
-        const u32 idx1 = m_Mesh->indices[m_Index + 1];
-        const u32 idx2 = m_Mesh->indices[m_Index + 2];
+        // Sutherland-Hodgman against the six box planes, every plane adds at most one vertex
+        std::array<glm::vec3, 9> polygon = { p[0], p[1], p[2] };
+        std::array<glm::vec3, 9> clipped;
+        u32 count = 3;
+
+        for (u32 axis = 0; axis < 3; ++axis) {
+            const Bounds& slab = clip.AxisBounds(axis);
+
+            for (u32 side = 0; side < 2; ++side) {
+                f32 plane = side ? slab.max : slab.min;
+                auto Inside = [&](const glm::vec3& v) { return side ? v[axis] <= plane : v[axis] >= plane; };
+
+                u32 clippedCount = 0;
+                for (u32 i = 0; i < count; ++i) {
+                    const glm::vec3& current = polygon[i];
+                    const glm::vec3& next = polygon[(i + 1) % count];
+
+                    bool currentInside = Inside(current);
+                    if (currentInside) {
+                        clipped[clippedCount++] = current;
+                    }
+
+                    if (currentInside != Inside(next)) {
+                        f32 t = (plane - current[axis]) / (next[axis] - current[axis]);
+                        glm::vec3 v = current + t * (next - current);
+                        v[axis] = plane;
+                        clipped[clippedCount++] = v;
+                    }
+                }
+
+                std::swap(polygon, clipped);
+                count = clippedCount;
+
+                if (count == 0) return AABB();
+            }
+        }
 
-        const glm::vec3& p0 = m_Mesh->p[idx0];
-        const glm::vec3& p1 = m_Mesh->p[idx1];
-        const glm::vec3& p2 = m_Mesh->p[idx2];
+        AABB bounds;
+        for (u32 i = 0; i < count; ++i) {
+            bounds = AABB(bounds, AABB(polygon[i], polygon[i]));
+        }
 
-        glm::vec3 e1 = p1 - p0;
-        glm::vec3 e2 = p2 - p0;
+        return bounds.Overlap(clip);
+    }
 
-        glm::vec3 s1 = glm::cross(ray.direction, e2);
+    f32 Triangle::Area(const Mesh& mesh, u32 triangle)
+    {
+        return Area(GetPositions(mesh, triangle));
+    }
 
-        f32 divisor = glm::dot(s1, e1);
-        f32 invDivisor = 1.0f / divisor;
+    f32 Triangle::Area(const TrianglePositions& p)
+    {
+        return 0.5f * glm::length(glm::cross(p[1] - p[0], p[2] - p[0]));
+    }
 
-        glm::vec3 s = ray.origin - p0;
-        f32 b1 = glm::dot(s, s1) * invDivisor;
+    void Triangle::FillSurfaceInteraction(const Mesh& mesh, u32 triangle, const Ray& ray, const HitInteraction& hit, const Shape* shape, SurfaceInteraction& intersection)
+    {
+        FillSurfaceInteraction(GetVertices(mesh, triangle), ray, hit, shape, intersection);
+    }
+
+    void Triangle::FillSurfaceInteraction(const TriangleVertices& vertices, const Ray& ray, const HitInteraction& hit, const Shape* shape, SurfaceInteraction& intersection)
+    {
+        const glm::vec3& p0 = vertices.p[0];
+        const glm::vec3& p1 = vertices.p[1];
+        const glm::vec3& p2 = vertices.p[2];
 
-        glm::vec3 s2 = glm::cross(s, e1);
-        f32 b2 = glm::dot(ray.direction, s2) * invDivisor;
+        glm::vec3 e1 = p1 - p0;
+        glm::vec3 e2 = p2 - p0;
 
+        f32 b1 = hit.barycentrics.x;
+        f32 b2 = hit.barycentrics.y;
         f32 b0 = 1.0f - b1 - b2;
 
         glm::vec3 pHit = b0 * p0 + b1 * p1 + b2 * p2;
@@ -102,10 +157,10 @@ namespace Silmaril {
         glm::vec3 pError = std::numeric_limits<f32>::epsilon() * 5.0f * pAbsSum;
 
         glm::vec2 uv0, uv1, uv2;
-        if (!m_Mesh->uv.empty()) {
-            uv0 = m_Mesh->uv[idx0];
-            uv1 = m_Mesh->uv[idx1];
-            uv2 = m_Mesh->uv[idx2];
+        if (vertices.hasUVs) {
+            uv0 = vertices.uv[0];
+            uv1 = vertices.uv[1];
+            uv2 = vertices.uv[2];
         } else {
             uv0 = glm::vec2(0.0f, 0.0f);
             uv1 = glm::vec2(1.0f, 0.0f);
@@ -143,13 +198,13 @@ namespace Silmaril {
         glm::vec3 dndu(0.0f);
         glm::vec3 dndv(0.0f);
 
-        intersection = SurfaceInteraction(pHit, pError, uvHit, -ray.direction, dpdu, dpdv, dndu, dndv, ray.time, this);
-        intersection.t = tHit;
+        intersection = SurfaceInteraction(pHit, pError, uvHit, -ray.direction, dpdu, dpdv, dndu, dndv, ray.time, shape);
+        intersection.t = hit.t;
 
-        if (!m_Mesh->n.empty()) {
-            const glm::vec3& n0 = m_Mesh->n[idx0];
-            const glm::vec3& n1 = m_Mesh->n[idx1];
-            const glm::vec3& n2 = m_Mesh->n[idx2];
+        if (vertices.hasNormals) {
+            const glm::vec3& n0 = vertices.n[0];
+            const glm::vec3& n1 = vertices.n[1];
+            const glm::vec3& n2 = vertices.n[2];
 
             glm::vec3 shadingNormal = glm::normalize(b0 * n0 + b1 * n1 + b2 * n2);
 
@@ -173,26 +228,27 @@ namespace Silmaril {
         }
     }
 
-    Interaction Triangle::Sample(const glm::vec2& u, f32& pdf) const
+    Interaction Triangle::Sample(const Mesh& mesh, u32 triangle, const glm::vec2& u, f32& pdf)
+    {
+        return Sample(GetVertices(mesh, triangle), u, pdf);
+    }
+
+    Interaction Triangle::Sample(const TriangleVertices& vertices, const glm::vec2& u, f32& pdf)
     {
         f32 su0 = glm::sqrt(u[0]);
         f32 b0 = 1.0f - su0;
         f32 b1 = u[1] * su0;
         f32 b2 = 1.0f - b0 - b1;
 
-        const u32 idx0 = m_Mesh->indices[m_Index + 0];
-        const u32 idx1 = m_Mesh->indices[m_Index + 1];
-        const u32 idx2 = m_Mesh->indices[m_Index + 2];
-
-        const glm::vec3& p0 = m_Mesh->p[idx0];
-        const glm::vec3& p1 = m_Mesh->p[idx1];
-        const glm::vec3& p2 = m_Mesh->p[idx2];
+        const glm::vec3& p0 = vertices.p[0];
+        const glm::vec3& p1 = vertices.p[1];
+        const glm::vec3& p2 = vertices.p[2];
 
         glm::vec3 p = b0 * p0 + b1 * p1 + b2 * p2;
 
         glm::vec3 n;
-        if (!m_Mesh->n.empty()) {
-            n = glm::normalize(b0 * m_Mesh->n[idx0] + b1 * m_Mesh->n[idx1] + b2 * m_Mesh->n[idx2]);
+        if (vertices.hasNormals) {
+            n = glm::normalize(b0 * vertices.n[0] + b1 * vertices.n[1] + b2 * vertices.n[2]);
         } else {
             n = glm::normalize(glm::cross(p1 - p0, p2 - p0));
         }
@@ -200,7 +256,7 @@ namespace Silmaril {
         glm::vec3 pAbsSum = glm::abs(b0 * p0) + glm::abs(b1 * p1) + glm::abs(b2 * p2);
         glm::vec3 pError = std::numeric_limits<f32>::epsilon() * 5.0f * pAbsSum;
 
-        pdf = 1.0f / Area();
+        pdf = 1.0f / Area(vertices.p);
 
         return Interaction(p, n, pError, glm::vec3(0.0f), 0.0f);
     }
@@ -1,10 +1,21 @@
 #pragma once
 
 #include "Shape.hpp"
+#include "Mesh.hpp"
 
 namespace Silmaril {
 
-    struct Mesh;
+    using TrianglePositions = std::array<glm::vec3, 3>;
+
+    // Corner attributes of one triangle, read from a mesh or decoded from compressed storage
+    struct TriangleVertices
+    {
+        TrianglePositions p;
+        std::array<glm::vec3, 3> n;
+        std::array<glm::vec2, 3> uv;
+        bool hasNormals { false };
+        bool hasUVs { false };
+    };
 
     class Triangle final : public Shape
     {
@@ -13,18 +24,89 @@ namespace Silmaril {
         virtual ~Triangle() = default;
 
         virtual AABB GetBound() const override;
+        virtual AABB GetClippedBound(const AABB& clip) const override;
         virtual f32 Area() const override;
 
-        virtual bool Intersect(const Ray& ray, f32& tHit, f32 tMax) const override;
-        virtual void FillSurfaceInteraction(const Ray& ray, f32 tHit, SurfaceInteraction& intersection) const override;
+        virtual bool Intersect(const Ray& ray, HitInteraction& hit) const override;
+        virtual void FillSurfaceInteraction(const Ray& ray, const HitInteraction& hit, SurfaceInteraction& intersection) const override;
 
         virtual Interaction Sample(const glm::vec2& u, f32& pdf) const override;
 
         static std::vector<std::shared_ptr<Shape>> CreateTriangleMesh(const std::shared_ptr<Mesh>& mesh);
 
+        // Triangle math on a mesh and triangle index, for storage that keeps no Triangle objects
+        static AABB GetBound(const Mesh& mesh, u32 triangle);
+        static AABB GetClippedBound(const Mesh& mesh, u32 triangle, const AABB& clip);
+        static f32 Area(const Mesh& mesh, u32 triangle);
+
+        static bool Intersect(const Mesh& mesh, u32 triangle, const Ray& ray, HitInteraction& hit);
+        static void FillSurfaceInteraction(const Mesh& mesh, u32 triangle, const Ray& ray, const HitInteraction& hit, const Shape* shape, SurfaceInteraction& intersection);
+
+        static Interaction Sample(const Mesh& mesh, u32 triangle, const glm::vec2& u, f32& pdf);
+
+        // The same math on corners that were already gathered or decoded
+        static TrianglePositions GetPositions(const Mesh& mesh, u32 triangle);
+        static TriangleVertices GetVertices(const Mesh& mesh, u32 triangle);
+
+        static AABB GetBound(const TrianglePositions& p);
+        static AABB GetClippedBound(const TrianglePositions& p, const AABB& clip);
+        static f32 Area(const TrianglePositions& p);
+
+        static bool Intersect(const TrianglePositions& p, const Ray& ray, HitInteraction& hit);
+        static void FillSurfaceInteraction(const TriangleVertices& vertices, const Ray& ray, const HitInteraction& hit, const Shape* shape, SurfaceInteraction& intersection);
+
+        static Interaction Sample(const TriangleVertices& vertices, const glm::vec2& u, f32& pdf);
+
     private:
         std::shared_ptr<Mesh> m_Mesh;
         u32 m_Index;
     };
 
+    inline TrianglePositions Triangle::GetPositions(const Mesh& mesh, u32 triangle)
+    {
+        const u32 base = triangle * 3;
+
+        return {
+            mesh.p[mesh.indices[base + 0]],
+            mesh.p[mesh.indices[base + 1]],
+            mesh.p[mesh.indices[base + 2]]
+        };
+    }
+
+    inline bool Triangle::Intersect(const Mesh& mesh, u32 triangle, const Ray& ray, HitInteraction& hit)
+    {
+        return Intersect(GetPositions(mesh, triangle), ray, hit);
+    }
+
+    inline bool Triangle::Intersect(const TrianglePositions& p, const Ray& ray, HitInteraction& hit)
+    {
+        const glm::vec3& p0 = p[0];
+
+        glm::vec3 e1 = p[1] - p0;
+        glm::vec3 e2 = p[2] - p0;
+
+        glm::vec3 s1 = glm::cross(ray.direction, e2);
+        f32 divisor = glm::dot(s1, e1);
+
+        if (divisor == 0.0f) return false;
+        f32 invDivisor = 1.0f / divisor;
+
+        glm::vec3 s = ray.origin - p0;
+        f32 b1 = glm::dot(s, s1) * invDivisor;
+        if (b1 < 0.0f || b1 > 1.0f) return false;
+
+        glm::vec3 s2 = glm::cross(s, e1);
+        f32 b2 = glm::dot(ray.direction, s2) * invDivisor;
+        if (b2 < 0.0f || b1 + b2 > 1.0f) return false;
+
+        f32 t = glm::dot(e2, s2) * invDivisor;
+
+        if (t < 0.0f || t > hit.t) return false;
+
+        hit.t = t;
+        hit.barycentrics = glm::vec2(b1, b2);
+
+        return true;
+    }
+
 }
@@ -0,0 +1,71 @@
+#include "TriangleMesh.hpp"
+
+#include "Silmaril/Core/Logger.hpp"
+
+namespace Silmaril {
+
+    TriangleMesh::TriangleMesh(
+        const std::shared_ptr<Mesh>& mesh,
+        const std::vector<std::shared_ptr<Material>>& materials,
+        const std::vector<glm::vec3>& emission,
+        const std::shared_ptr<Material>& defaultMaterial
+    )
+        : m_Mesh(mesh), m_Materials(materials)
+    {
+        InitMaterialSlots(*m_Mesh, emission, defaultMaterial);
+    }
+
+    TriangleMesh::TriangleMesh(
+        const Mesh& mesh,
+        const CompressedMesh::Config& compression,
+        const std::vector<std::shared_ptr<Material>>& materials,
+        const std::vector<glm::vec3>& emission,
+        const std::shared_ptr<Material>& defaultMaterial
+    )
+        : m_Compressed(std::make_shared<CompressedMesh>(mesh, compression)), m_Materials(materials)
+    {
+        InitMaterialSlots(mesh, emission, defaultMaterial);
+    }
+
+    void TriangleMesh::InitMaterialSlots(const Mesh& mesh, const std::vector<glm::vec3>& emission, const std::shared_ptr<Material>& defaultMaterial)
+    {
+        constexpr usize maxMaterials = std::numeric_limits<u16>::max();
+        if (m_Materials.size() >= maxMaterials) {
+            LOG_WARN("Mesh references {} materials, only the first {} are used", m_Materials.size(), maxMaterials - 1);
+            m_Materials.resize(maxMaterials - 1);
+        }
+
+        // Triangles without a valid material, or meshes without material ids, fall back to the first material or the default
+        u16 defaultSlot = static_cast<u16>(m_Materials.size());
+        u16 fallbackSlot = m_Materials.empty() ? defaultSlot : 0;
+        m_Materials.push_back(defaultMaterial);
+
+        // The default material never emits, nor do materials without an entry
+        m_Emission.assign(m_Materials.size(), glm::vec3(0.0f));
+        std::copy_n(emission.begin(), std::min(emission.size(), static_cast<usize>(defaultSlot)), m_Emission.begin());
+
+        u32 nTriangles = GetTriangleCount();
+        m_MaterialSlots.resize(nTriangles, fallbackSlot);
+
+        if (!mesh.materials.empty()) {
+            for (u32 i = 0; i < nTriangles; ++i) {
+                i32 id = mesh.materials[i];
+                m_MaterialSlots[i] = (id >= 0 && id < defaultSlot) ? static_cast<u16>(id) : defaultSlot;
+            }
+        }
+
+        m_Emissive = std::ranges::any_of(m_MaterialSlots, [&](u16 slot) { return m_Emission[slot] != glm::vec3(0.0f); });
+    }
+
+    void TriangleMesh::FillSurfaceInteraction(const Ray& ray, u32 triangle, const HitInteraction& hit, SurfaceInteraction& intersection) const
+    {
+        if (m_Compressed) {
+            Triangle::FillSurfaceInteraction(m_Compressed->GetVertices(triangle), ray, hit, nullptr, intersection);
+        } else {
+            Triangle::FillSurfaceInteraction(*m_Mesh, triangle, ray, hit, nullptr, intersection);
+        }
+        intersection.material = GetMaterial(triangle);
+        intersection.triangle = triangle;
+    }
+
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Triangle.hpp"
+#include "CompressedMesh.hpp"
+
+#include "Silmaril/PBRT/Materials/Material.hpp"
+
+namespace Silmaril {
+
+    // Triangles kept as the mesh's own index and vertex arrays, or as a compressed copy of them, plus one material
+    // slot per triangle. Aggregates address a triangle by its index, no object is allocated per triangle.
+    // Each slot may also emit, see MeshLight.
+    class TriangleMesh
+    {
+    public:
+        TriangleMesh(
+            const std::shared_ptr<Mesh>& mesh,
+            const std::vector<std::shared_ptr<Material>>& materials,
+            const std::vector<glm::vec3>& emission,
+            const std::shared_ptr<Material>& defaultMaterial
+        );
+
+        // Keeps only the compressed attributes, the source mesh can be released afterwards
+        TriangleMesh(
+            const Mesh& mesh,
+            const CompressedMesh::Config& compression,
+            const std::vector<std::shared_ptr<Material>>& materials,
+            const std::vector<glm::vec3>& emission,
+            const std::shared_ptr<Material>& defaultMaterial
+        );
+
+        inline u32 GetTriangleCount() const { return m_Compressed ? m_Compressed->GetTriangleCount() : static_cast<u32>(m_Mesh->indices.size() / 3); }
+
+        // Null for compressed meshes
+        inline const std::shared_ptr<Mesh>& GetMesh() const { return m_Mesh; }
+        inline const std::shared_ptr<CompressedMesh>& GetCompressedMesh() const { return m_Compressed; }
+
+        inline TrianglePositions GetPositions(u32 triangle) const
+        {
+            return m_Compressed ? m_Compressed->GetPositions(triangle) : Triangle::GetPositions(*m_Mesh, triangle);
+        }
+
+        inline TriangleVertices GetVertices(u32 triangle) const
+        {
+            return m_Compressed ? m_Compressed->GetVertices(triangle) : Triangle::GetVertices(*m_Mesh, triangle);
+        }
+
+        inline AABB GetBound(u32 triangle) const { return Triangle::GetBound(GetPositions(triangle)); }
+        inline AABB GetClippedBound(u32 triangle, const AABB& clip) const { return Triangle::GetClippedBound(GetPositions(triangle), clip); }
+
+        inline const Material* GetMaterial(u32 triangle) const { return m_Materials[m_MaterialSlots[triangle]].get(); }
+
+        // Radiance the triangle's material emits, zero for most
+        inline const glm::vec3& GetEmission(u32 triangle) const { return m_Emission[m_MaterialSlots[triangle]]; }
+        inline bool IsEmissive() const { return m_Emissive; }
+
+        inline bool Intersect(const Ray& ray, u32 triangle, HitInteraction& hit) const
+        {
+            return Triangle::Intersect(GetPositions(triangle), ray, hit);
+        }
+
+        void FillSurfaceInteraction(const Ray& ray, u32 triangle, const HitInteraction& hit, SurfaceInteraction& intersection) const;
+
+        // Bytes used per triangle by the index and material arrays
+        inline usize GetTriangleBytes() const { return (m_Compressed ? 3 * sizeof(u8) : 3 * sizeof(u32)) + sizeof(u16); }
+
+    private:
+        void InitMaterialSlots(const Mesh& mesh, const std::vector<glm::vec3>& emission, const std::shared_ptr<Material>& defaultMaterial);
+
+    private:
+        std::shared_ptr<Mesh> m_Mesh;
+        std::shared_ptr<CompressedMesh> m_Compressed;
+
+        // The default material is the last slot
+        std::vector<std::shared_ptr<Material>> m_Materials;
+        std::vector<u16> m_MaterialSlots;
+        // One per material slot
+        std::vector<glm::vec3> m_Emission;
+        bool m_Emissive { false };
+    };
+
+}
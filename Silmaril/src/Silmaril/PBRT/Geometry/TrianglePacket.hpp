@@ -0,0 +1,278 @@
+#pragma once
+
+#include "Silmaril/Core/SIMD.hpp"
+
+#include "Silmaril/PBRT/Containers/Ray.hpp"
+
+namespace Silmaril {
+
+    // N triangles stored as SoA vertex and edge vectors so one SIMD Moller-Trumbore test covers all of them.
+    // Unused lanes keep zero edges, their determinant is zero and they never report a hit.
+    template <u32 N>
+    struct alignas(32) TrianglePacket
+    {
+        f32 p0x[N];
+        f32 p0y[N];
+        f32 p0z[N];
+        f32 e1x[N];
+        f32 e1y[N];
+        f32 e1z[N];
+        f32 e2x[N];
+        f32 e2y[N];
+        f32 e2z[N];
+
+        TrianglePacket()
+        {
+            for (u32 i = 0; i < N; ++i) {
+                p0x[i] = p0y[i] = p0z[i] = 0.0f;
+                e1x[i] = e1y[i] = e1z[i] = 0.0f;
+                e2x[i] = e2y[i] = e2z[i] = 0.0f;
+            }
+        }
+
+        inline void SetTriangle(u32 lane, const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2)
+        {
+            glm::vec3 e1 = p1 - p0;
+            glm::vec3 e2 = p2 - p0;
+
+            p0x[lane] = p0.x;
+            p0y[lane] = p0.y;
+            p0z[lane] = p0.z;
+            e1x[lane] = e1.x;
+            e1y[lane] = e1.y;
+            e1z[lane] = e1.z;
+            e2x[lane] = e2.x;
+            e2y[lane] = e2.y;
+            e2z[lane] = e2.z;
+        }
+    };
+
+    using TrianglePacket4 = TrianglePacket<4>;
+    using TrianglePacket8 = TrianglePacket<8>;
+
+    // Nearest hit of a packet test, b1 and b2 weight the second and third vertex
+    struct TrianglePacketHit
+    {
+        f32 t;
+        f32 b1;
+        f32 b2;
+        u32 lane;
+    };
+
+    class TrianglePacketTest
+    {
+    public:
+        // Tests every lane against the ray, returns a bitmask of lanes hit within [0, tMax] and writes their distances and barycentrics
+        template <u32 N>
+        static u32 Intersect(const TrianglePacket<N>& packet, const Ray& ray, f32 tMax, f32* t, f32* b1, f32* b2);
+
+        template <u32 N>
+        static bool IntersectNearest(const TrianglePacket<N>& packet, const Ray& ray, f32 tMax, TrianglePacketHit& hit)
+        {
+            alignas(32) f32 t[N];
+            alignas(32) f32 b1[N];
+            alignas(32) f32 b2[N];
+
+            u32 mask = Intersect<N>(packet, ray, tMax, t, b1, b2);
+            if (!mask) return false;
+
+            hit.t = std::numeric_limits<f32>::infinity();
+            while (mask) {
+                u32 lane = static_cast<u32>(std::countr_zero(mask));
+                mask &= mask - 1;
+
+                if (t[lane] < hit.t) {
+                    hit = { t[lane], b1[lane], b2[lane], lane };
+                }
+            }
+
+            return true;
+        }
+    };
+
+    namespace TrianglePacketDetail {
+
+        // Same operation order as Triangle::Intersect so every path reports bit-identical distances
+        inline u32 IntersectScalar(
+            u32 count,
+            const f32* p0x, const f32* p0y, const f32* p0z,
+            const f32* e1x, const f32* e1y, const f32* e1z,
+            const f32* e2x, const f32* e2y, const f32* e2z,
+            const Ray& ray, f32 tMax, f32* t, f32* b1, f32* b2
+        )
+        {
+            u32 mask = 0;
+            for (u32 i = 0; i < count; ++i) {
+                glm::vec3 e1(e1x[i], e1y[i], e1z[i]);
+                glm::vec3 e2(e2x[i], e2y[i], e2z[i]);
+
+                glm::vec3 s1 = glm::cross(ray.direction, e2);
+                f32 divisor = glm::dot(s1, e1);
+                if (divisor == 0.0f) continue;
+                f32 invDivisor = 1.0f / divisor;
+
+                glm::vec3 s = ray.origin - glm::vec3(p0x[i], p0y[i], p0z[i]);
+                f32 u = glm::dot(s, s1) * invDivisor;
+                if (!(u >= 0.0f && u <= 1.0f)) continue;
+
+                glm::vec3 s2 = glm::cross(s, e1);
+                f32 v = glm::dot(ray.direction, s2) * invDivisor;
+                if (!(v >= 0.0f && u + v <= 1.0f)) continue;
+
+                f32 distance = glm::dot(e2, s2) * invDivisor;
+                if (!(distance >= 0.0f && distance <= tMax)) continue;
+
+                t[i] = distance;
+                b1[i] = u;
+                b2[i] = v;
+                mask |= 1u << i;
+            }
+            return mask;
+        }
+
+#if defined(SILMARIL_SIMD_SSE)
+
+        inline u32 Intersect4(
+            const f32* p0x, const f32* p0y, const f32* p0z,
+            const f32* e1x, const f32* e1y, const f32* e1z,
+            const f32* e2x, const f32* e2y, const f32* e2z,
+            const Ray& ray, f32 tMax, f32* t, f32* b1, f32* b2
+        )
+        {
+            const __m128 dx = _mm_set1_ps(ray.direction.x);
+            const __m128 dy = _mm_set1_ps(ray.direction.y);
+            const __m128 dz = _mm_set1_ps(ray.direction.z);
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+
+            const __m128 ex1 = _mm_load_ps(e1x);
+            const __m128 ey1 = _mm_load_ps(e1y);
+            const __m128 ez1 = _mm_load_ps(e1z);
+            const __m128 ex2 = _mm_load_ps(e2x);
+            const __m128 ey2 = _mm_load_ps(e2y);
+            const __m128 ez2 = _mm_load_ps(e2z);
+
+            // s1 = d x e2, divisor = s1 . e1
+            __m128 s1x = _mm_sub_ps(_mm_mul_ps(dy, ez2), _mm_mul_ps(ey2, dz));
+            __m128 s1y = _mm_sub_ps(_mm_mul_ps(dz, ex2), _mm_mul_ps(ez2, dx));
+            __m128 s1z = _mm_sub_ps(_mm_mul_ps(dx, ey2), _mm_mul_ps(ex2, dy));
+            __m128 divisor = _mm_add_ps(_mm_add_ps(_mm_mul_ps(s1x, ex1), _mm_mul_ps(s1y, ey1)), _mm_mul_ps(s1z, ez1));
+            __m128 invDivisor = _mm_div_ps(one, divisor);
+
+            __m128 sx = _mm_sub_ps(_mm_set1_ps(ray.origin.x), _mm_load_ps(p0x));
+            __m128 sy = _mm_sub_ps(_mm_set1_ps(ray.origin.y), _mm_load_ps(p0y));
+            __m128 sz = _mm_sub_ps(_mm_set1_ps(ray.origin.z), _mm_load_ps(p0z));
+            __m128 u = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(sx, s1x), _mm_mul_ps(sy, s1y)), _mm_mul_ps(sz, s1z)), invDivisor);
+
+            // s2 = s x e1
+            __m128 s2x = _mm_sub_ps(_mm_mul_ps(sy, ez1), _mm_mul_ps(ey1, sz));
+            __m128 s2y = _mm_sub_ps(_mm_mul_ps(sz, ex1), _mm_mul_ps(ez1, sx));
+            __m128 s2z = _mm_sub_ps(_mm_mul_ps(sx, ey1), _mm_mul_ps(ex1, sy));
+            __m128 v = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, s2x), _mm_mul_ps(dy, s2y)), _mm_mul_ps(dz, s2z)), invDivisor);
+            __m128 distance = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(ex2, s2x), _mm_mul_ps(ey2, s2y)), _mm_mul_ps(ez2, s2z)), invDivisor);
+
+            __m128 valid = _mm_cmpneq_ps(divisor, zero);
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(u, zero), _mm_cmple_ps(u, one)));
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(v, zero), _mm_cmple_ps(_mm_add_ps(u, v), one)));
+            valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(distance, zero), _mm_cmple_ps(distance, _mm_set1_ps(tMax))));
+
+            _mm_store_ps(t, distance);
+            _mm_store_ps(b1, u);
+            _mm_store_ps(b2, v);
+            return static_cast<u32>(_mm_movemask_ps(valid));
+        }
+#endif
+
+    }
+
+    template <>
+    inline u32 TrianglePacketTest::Intersect<4>(const TrianglePacket<4>& packet, const Ray& ray, f32 tMax, f32* t, f32* b1, f32* b2)
+    {
+#if defined(SILMARIL_SIMD_SSE)
+        return TrianglePacketDetail::Intersect4(
+            packet.p0x, packet.p0y, packet.p0z,
+            packet.e1x, packet.e1y, packet.e1z,
+            packet.e2x, packet.e2y, packet.e2z,
+            ray, tMax, t, b1, b2
+        );
+#else
+        return TrianglePacketDetail::IntersectScalar(
+            4,
+            packet.p0x, packet.p0y, packet.p0z,
+            packet.e1x, packet.e1y, packet.e1z,
+            packet.e2x, packet.e2y, packet.e2z,
+            ray, tMax, t, b1, b2
+        );
+#endif
+    }
+
+    template <>
+    inline u32 TrianglePacketTest::Intersect<8>(const TrianglePacket<8>& packet, const Ray& ray, f32 tMax, f32* t, f32* b1, f32* b2)
+    {
+#if defined(SILMARIL_SIMD_AVX2)
+        const __m256 dx = _mm256_set1_ps(ray.direction.x);
+        const __m256 dy = _mm256_set1_ps(ray.direction.y);
+        const __m256 dz = _mm256_set1_ps(ray.direction.z);
+        const __m256 zero = _mm256_setzero_ps();
+        const __m256 one = _mm256_set1_ps(1.0f);
+
+        const __m256 ex1 = _mm256_load_ps(packet.e1x);
+        const __m256 ey1 = _mm256_load_ps(packet.e1y);
+        const __m256 ez1 = _mm256_load_ps(packet.e1z);
+        const __m256 ex2 = _mm256_load_ps(packet.e2x);
+        const __m256 ey2 = _mm256_load_ps(packet.e2y);
+        const __m256 ez2 = _mm256_load_ps(packet.e2z);
+
+        // Explicit mul and add instead of FMA keeps the distances identical to the scalar test
+        __m256 s1x = _mm256_sub_ps(_mm256_mul_ps(dy, ez2), _mm256_mul_ps(ey2, dz));
+        __m256 s1y = _mm256_sub_ps(_mm256_mul_ps(dz, ex2), _mm256_mul_ps(ez2, dx));
+        __m256 s1z = _mm256_sub_ps(_mm256_mul_ps(dx, ey2), _mm256_mul_ps(ex2, dy));
+        __m256 divisor = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(s1x, ex1), _mm256_mul_ps(s1y, ey1)), _mm256_mul_ps(s1z, ez1));
+        __m256 invDivisor = _mm256_div_ps(one, divisor);
+
+        __m256 sx = _mm256_sub_ps(_mm256_set1_ps(ray.origin.x), _mm256_load_ps(packet.p0x));
+        __m256 sy = _mm256_sub_ps(_mm256_set1_ps(ray.origin.y), _mm256_load_ps(packet.p0y));
+        __m256 sz = _mm256_sub_ps(_mm256_set1_ps(ray.origin.z), _mm256_load_ps(packet.p0z));
+        __m256 u = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(sx, s1x), _mm256_mul_ps(sy, s1y)), _mm256_mul_ps(sz, s1z)), invDivisor);
+
+        __m256 s2x = _mm256_sub_ps(_mm256_mul_ps(sy, ez1), _mm256_mul_ps(ey1, sz));
+        __m256 s2y = _mm256_sub_ps(_mm256_mul_ps(sz, ex1), _mm256_mul_ps(ez1, sx));
+        __m256 s2z = _mm256_sub_ps(_mm256_mul_ps(sx, ey1), _mm256_mul_ps(ex1, sy));
+        __m256 v = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, s2x), _mm256_mul_ps(dy, s2y)), _mm256_mul_ps(dz, s2z)), invDivisor);
+        __m256 distance = _mm256_mul_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(ex2, s2x), _mm256_mul_ps(ey2, s2y)), _mm256_mul_ps(ez2, s2z)), invDivisor);
+
+        __m256 valid = _mm256_cmp_ps(divisor, zero, _CMP_NEQ_OQ);
+        valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(u, zero, _CMP_GE_OQ), _mm256_cmp_ps(u, one, _CMP_LE_OQ)));
+        valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(v, zero, _CMP_GE_OQ), _mm256_cmp_ps(_mm256_add_ps(u, v), one, _CMP_LE_OQ)));
+        valid = _mm256_and_ps(valid, _mm256_and_ps(_mm256_cmp_ps(distance, zero, _CMP_GE_OQ), _mm256_cmp_ps(distance, _mm256_set1_ps(tMax), _CMP_LE_OQ)));
+
+        _mm256_store_ps(t, distance);
+        _mm256_store_ps(b1, u);
+        _mm256_store_ps(b2, v);
+        return static_cast<u32>(_mm256_movemask_ps(valid));
+#elif defined(SILMARIL_SIMD_SSE)
+        u32 lo = TrianglePacketDetail::Intersect4(
+            packet.p0x, packet.p0y, packet.p0z,
+            packet.e1x, packet.e1y, packet.e1z,
+            packet.e2x, packet.e2y, packet.e2z,
+            ray, tMax, t, b1, b2
+        );
+        u32 hi = TrianglePacketDetail::Intersect4(
+            packet.p0x + 4, packet.p0y + 4, packet.p0z + 4,
+            packet.e1x + 4, packet.e1y + 4, packet.e1z + 4,
+            packet.e2x + 4, packet.e2y + 4, packet.e2z + 4,
+            ray, tMax, t + 4, b1 + 4, b2 + 4
+        );
+        return lo | (hi << 4);
+#else
+        return TrianglePacketDetail::IntersectScalar(
+            8,
+            packet.p0x, packet.p0y, packet.p0z,
+            packet.e1x, packet.e1y, packet.e1z,
+            packet.e2x, packet.e2y, packet.e2z,
+            ray, tMax, t, b1, b2
+        );
+#endif
+    }
+
+}
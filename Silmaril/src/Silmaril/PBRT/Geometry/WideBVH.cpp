@@ -0,0 +1,79 @@
+#include "WideBVH.hpp"
+#include "BVH.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        template <u32 N>
+        u32 CollapseRecursive(const std::vector<LinearBVHNode>& nodes, u32 binaryIndex, std::vector<WideBVHNode<N>>& wideNodes)
+        {
+            u32 wideIndex = static_cast<u32>(wideNodes.size());
+            wideNodes.emplace_back();
+
+            std::array<u32, N> candidates;
+            u32 count = 0;
+
+            const LinearBVHNode& root = nodes[binaryIndex];
+            if (root.nPrimitives > 0) {
+                candidates[count++] = binaryIndex;
+            } else {
+                candidates[count++] = binaryIndex + 1;
+                candidates[count++] = root.secondChildOffset;
+            }
+
+            // Keep opening the largest interior candidate until the node is full
+            while (count < N) {
+                i32 best = -1;
+                f32 bestArea = -1.0f;
+
+                for (u32 i = 0; i < count; ++i) {
+                    const LinearBVHNode& candidate = nodes[candidates[i]];
+                    if (candidate.nPrimitives > 0) continue;
+
+                    f32 area = candidate.bounds.SurfaceArea();
+                    if (area > bestArea) {
+                        bestArea = area;
+                        best = static_cast<i32>(i);
+                    }
+                }
+
+                if (best < 0) break;
+
+                u32 opened = candidates[best];
+                candidates[best] = opened + 1;
+                candidates[count++] = nodes[opened].secondChildOffset;
+            }
+
+            for (u32 i = 0; i < count; ++i) {
+                const LinearBVHNode& child = nodes[candidates[i]];
+
+                u32 childIndex = child.primitivesOffset;
+                if (child.nPrimitives == 0) {
+                    childIndex = CollapseRecursive(nodes, candidates[i], wideNodes);
+                }
+
+                wideNodes[wideIndex].SetChild(i, child.bounds, childIndex, child.nPrimitives);
+            }
+
+            return wideIndex;
+        }
+
+    }
+
+    template <u32 N>
+    std::vector<WideBVHNode<N>> WideBVH::Collapse(const std::vector<LinearBVHNode>& nodes)
+    {
+        std::vector<WideBVHNode<N>> wideNodes;
+        if (nodes.empty()) return wideNodes;
+
+        wideNodes.reserve(nodes.size() / (N - 1) + 1);
+        CollapseRecursive<N>(nodes, 0, wideNodes);
+
+        return wideNodes;
+    }
+
+    template std::vector<WideBVHNode<4>> WideBVH::Collapse<4>(const std::vector<LinearBVHNode>& nodes);
+    template std::vector<WideBVHNode<8>> WideBVH::Collapse<8>(const std::vector<LinearBVHNode>& nodes);
+
+}
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "Silmaril/Core/SIMD.hpp"
+
+#include "Silmaril/PBRT/Containers/AABB.hpp"
+#include "Silmaril/PBRT/Containers/Ray.hpp"
+
+namespace Silmaril {
+
+    struct LinearBVHNode;
+
+    // N-wide node with the children's bounds stored as SoA so one SIMD slab test covers every child.
+    // Empty slots hold inverted bounds and never pass the slab test.
+    template <u32 N>
+    struct alignas(32) WideBVHNode
+    {
+        f32 minX[N];
+        f32 maxX[N];
+        f32 minY[N];
+        f32 maxY[N];
+        f32 minZ[N];
+        f32 maxZ[N];
+
+        // Wide node index for interior children, first primitive for leaves
+        u32 children[N];
+        u16 nPrimitives[N];
+
+        WideBVHNode()
+        {
+            for (u32 i = 0; i < N; ++i) {
+                minX[i] = minY[i] = minZ[i] = std::numeric_limits<f32>::infinity();
+                maxX[i] = maxY[i] = maxZ[i] = -std::numeric_limits<f32>::infinity();
+                children[i] = 0;
+                nPrimitives[i] = 0;
+            }
+        }
+
+        inline void SetChild(u32 slot, const AABB& bounds, u32 child, u16 count)
+        {
+            minX[slot] = bounds.x.min;
+            maxX[slot] = bounds.x.max;
+            minY[slot] = bounds.y.min;
+            maxY[slot] = bounds.y.max;
+            minZ[slot] = bounds.z.min;
+            maxZ[slot] = bounds.z.max;
+            children[slot] = child;
+            nPrimitives[slot] = count;
+        }
+    };
+
+    using BVH4Node = WideBVHNode<4>;
+    using BVH8Node = WideBVHNode<8>;
+
+    struct WideBVHRay
+    {
+        glm::vec3 origin;
+        glm::vec3 invDirection;
+        u32 dirIsNeg[3];
+
+        WideBVHRay(const Ray& ray)
+            : origin(ray.origin), invDirection(ray.invDirection)
+        {
+            dirIsNeg[0] = ray.invDirection.x < 0.0f;
+            dirIsNeg[1] = ray.invDirection.y < 0.0f;
+            dirIsNeg[2] = ray.invDirection.z < 0.0f;
+        }
+    };
+
+    class WideBVH
+    {
+    public:
+        template <u32 N>
+        static std::vector<WideBVHNode<N>> Collapse(const std::vector<LinearBVHNode>& nodes);
+
+        // Slab test against every child, returns a bitmask of hit slots and writes their entry distances
+        template <u32 N>
+        static u32 IntersectChildren(const WideBVHNode<N>& node, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear);
+    };
+
+    namespace WideBVHDetail {
+
+        inline u32 IntersectChildrenScalar(
+            u32 count,
+            const f32* nearX, const f32* farX,
+            const f32* nearY, const f32* farY,
+            const f32* nearZ, const f32* farZ,
+            const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear
+        )
+        {
+            u32 mask = 0;
+            for (u32 i = 0; i < count; ++i) {
+                f32 t0 = tMin;
+                f32 t1 = tMax;
+                t0 = std::max(t0, (nearX[i] - ray.origin.x) * ray.invDirection.x);
+                t1 = std::min(t1, (farX[i] - ray.origin.x) * ray.invDirection.x);
+                t0 = std::max(t0, (nearY[i] - ray.origin.y) * ray.invDirection.y);
+                t1 = std::min(t1, (farY[i] - ray.origin.y) * ray.invDirection.y);
+                t0 = std::max(t0, (nearZ[i] - ray.origin.z) * ray.invDirection.z);
+                t1 = std::min(t1, (farZ[i] - ray.origin.z) * ray.invDirection.z);
+                tNear[i] = t0;
+                mask |= (t0 <= t1) ? (1u << i) : 0u;
+            }
+            return mask;
+        }
+
+#if defined(SILMARIL_SIMD_SSE)
+
+        inline u32 IntersectChildren4(
+            const f32* nearX, const f32* farX,
+            const f32* nearY, const f32* farY,
+            const f32* nearZ, const f32* farZ,
+            const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear
+        )
+        {
+            const __m128 ox = _mm_set1_ps(ray.origin.x);
+            const __m128 oy = _mm_set1_ps(ray.origin.y);
+            const __m128 oz = _mm_set1_ps(ray.origin.z);
+            const __m128 idx = _mm_set1_ps(ray.invDirection.x);
+            const __m128 idy = _mm_set1_ps(ray.invDirection.y);
+            const __m128 idz = _mm_set1_ps(ray.invDirection.z);
+
+            // The running interval is the second operand so a NaN slab (origin on a plane, zero direction) is ignored
+            __m128 t0 = _mm_set1_ps(tMin);
+            __m128 t1 = _mm_set1_ps(tMax);
+
+            t0 = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(nearX), ox), idx), t0);
+            t1 = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(farX), ox), idx), t1);
+            t0 = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(nearY), oy), idy), t0);
+            t1 = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(farY), oy), idy), t1);
+            t0 = _mm_max_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(nearZ), oz), idz), t0);
+            t1 = _mm_min_ps(_mm_mul_ps(_mm_sub_ps(_mm_load_ps(farZ), oz), idz), t1);
+
+            _mm_store_ps(tNear, t0);
+            return static_cast<u32>(_mm_movemask_ps(_mm_cmple_ps(t0, t1)));
+        }
+#endif
+
+    }
+
+    template <>
+    inline u32 WideBVH::IntersectChildren<4>(const WideBVHNode<4>& node, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear)
+    {
+        const f32* nearX = ray.dirIsNeg[0] ? node.maxX : node.minX;
+        const f32* farX  = ray.dirIsNeg[0] ? node.minX : node.maxX;
+        const f32* nearY = ray.dirIsNeg[1] ? node.maxY : node.minY;
+        const f32* farY  = ray.dirIsNeg[1] ? node.minY : node.maxY;
+        const f32* nearZ = ray.dirIsNeg[2] ? node.maxZ : node.minZ;
+        const f32* farZ  = ray.dirIsNeg[2] ? node.minZ : node.maxZ;
+
+#if defined(SILMARIL_SIMD_SSE)
+        return WideBVHDetail::IntersectChildren4(nearX, farX, nearY, farY, nearZ, farZ, ray, tMin, tMax, tNear);
+#else
+        return WideBVHDetail::IntersectChildrenScalar(4, nearX, farX, nearY, farY, nearZ, farZ, ray, tMin, tMax, tNear);
+#endif
+    }
+
+    template <>
+    inline u32 WideBVH::IntersectChildren<8>(const WideBVHNode<8>& node, const WideBVHRay& ray, f32 tMin, f32 tMax, f32* tNear)
+    {
+        const f32* nearX = ray.dirIsNeg[0] ? node.maxX : node.minX;
+        const f32* farX  = ray.dirIsNeg[0] ? node.minX : node.maxX;
+        const f32* nearY = ray.dirIsNeg[1] ? node.maxY : node.minY;
+        const f32* farY  = ray.dirIsNeg[1] ? node.minY : node.maxY;
+        const f32* nearZ = ray.dirIsNeg[2] ? node.maxZ : node.minZ;
+        const f32* farZ  = ray.dirIsNeg[2] ? node.minZ : node.maxZ;
+
+#if defined(SILMARIL_SIMD_AVX2)
+        const __m256 ox = _mm256_set1_ps(ray.origin.x);
+        const __m256 oy = _mm256_set1_ps(ray.origin.y);
+        const __m256 oz = _mm256_set1_ps(ray.origin.z);
+        const __m256 idx = _mm256_set1_ps(ray.invDirection.x);
+        const __m256 idy = _mm256_set1_ps(ray.invDirection.y);
+        const __m256 idz = _mm256_set1_ps(ray.invDirection.z);
+
+        __m256 t0 = _mm256_set1_ps(tMin);
+        __m256 t1 = _mm256_set1_ps(tMax);
+
+        t0 = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nearX), ox), idx), t0);
+        t1 = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(farX), ox), idx), t1);
+        t0 = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nearY), oy), idy), t0);
+        t1 = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(farY), oy), idy), t1);
+        t0 = _mm256_max_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(nearZ), oz), idz), t0);
+        t1 = _mm256_min_ps(_mm256_mul_ps(_mm256_sub_ps(_mm256_load_ps(farZ), oz), idz), t1);
+
+        _mm256_store_ps(tNear, t0);
+        return static_cast<u32>(_mm256_movemask_ps(_mm256_cmp_ps(t0, t1, _CMP_LE_OQ)));
+#elif defined(SILMARIL_SIMD_SSE)
+        u32 lo = WideBVHDetail::IntersectChildren4(nearX, farX, nearY, farY, nearZ, farZ, ray, tMin, tMax, tNear);
+        u32 hi = WideBVHDetail::IntersectChildren4(nearX + 4, farX + 4, nearY + 4, farY + 4, nearZ + 4, farZ + 4, ray, tMin, tMax, tNear + 4);
+        return lo | (hi << 4);
+#else
+        return WideBVHDetail::IntersectChildrenScalar(8, nearX, farX, nearY, farY, nearZ, farZ, ray, tMin, tMax, tNear);
+#endif
+    }
+
+}
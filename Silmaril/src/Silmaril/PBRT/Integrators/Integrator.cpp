@@ -7,4 +7,10 @@ namespace Silmaril {
     {
     }
 
+    glm::vec3 Integrator::Sky(const glm::vec3& direction)
+    {
+        f32 t = 0.5f * (glm::normalize(direction).y + 1.0f);
+        return glm::mix(glm::vec3(1.0f), glm::vec3(0.5f, 0.7f, 1.0f), t);
+    }
+
 }
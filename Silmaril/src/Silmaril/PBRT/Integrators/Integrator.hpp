@@ -1,5 +1,7 @@
 #pragma once
 
+#include <glm/glm.hpp>
+
 namespace Silmaril {
 
     class Scene;
@@ -22,6 +24,17 @@ namespace Silmaril {
             m_RenderCallback = callback;
         }
 
+    protected:
+        inline static f32 PowerHeuristic(f32 f, f32 g)
+        {
+            f32 f2 = f * f;
+            f32 g2 = g * g;
+            return f2 / (f2 + g2);
+        }
+
+        // Radiance of rays leaving the scene
+        static glm::vec3 Sky(const glm::vec3& direction);
+
     protected:
         u32 m_TileSize { 0 };
         OnRenderCallback m_RenderCallback { nullptr };
@@ -1,4 +1,5 @@
 #include "RandomWalkIntegrator.hpp"
+#include "RenderBudget.hpp"
 
 #include "Silmaril/PBRT/Cameras/Camera.hpp"
 #include "Silmaril/PBRT/Samplers/Sampler.hpp"
@@ -12,17 +13,6 @@
 
 namespace Silmaril {
 
-    namespace {
-
-        f32 PowerHeuristic(f32 f, f32 g)
-        {
-            f32 f2 = f * f;
-            f32 g2 = g * g;
-            return f2 / (f2 + g2);
-        }
-    
-    }
-
     RandomWalkIntegrator::RandomWalkIntegrator(const Config& config)
         :   Integrator(config.tile),
             m_Config(config)
@@ -33,9 +23,13 @@ namespace Silmaril {
     {
         m_CancelRender = false;
 
+        RenderBudget budget(m_Config.timeBudget);
+
         const auto& camera = m_Config.camera;
         const auto& sampler = m_Config.sampler;
 
+        camera->GetFilm().Clear();
+
         u32 width = camera->GetFilm().GetWidth();
         u32 height = camera->GetFilm().GetHeight();
 
@@ -58,43 +52,154 @@ namespace Silmaril {
 
         LOG_INFO("Rendering {} tiles ({}x{}) for {} samples", totalTiles, m_TileSize, m_TileSize, sampler->GetSPP());
 
-        for (u32 pass = 1; pass < (sampler->GetSPP() + 1); ++pass) {
-            auto start = std::chrono::steady_clock::now();
+        const bool adaptive = m_Config.adaptiveThreshold > 0.0f;
+        const u32 spp = sampler->GetSPP();
+        const u32 blockSamples = std::max(m_Config.tileSamples, 1u);
 
-            JobSystem::Dispatch(static_cast<u32>(tiles.size()), 1, [&](JobDispatchArgs args) {
-                if (m_CancelRender) return;
+        // Samples each tile finished, and whether it stopped early because every pixel converged
+        std::vector<u32> tileSamples(totalTiles, 0);
+        std::vector<u8> tileConverged(totalTiles, 0);
 
-                const Tile& tile = tiles[args.jobIndex];
+        // Tiles done with each pass, whether they rendered it or dropped out before, the last one to arrive logs the pass
+        std::vector<std::atomic<u32>> passTiles(spp);
+        std::vector<std::atomic<u32>> passRendered(spp);
 
-                RenderTile(tile, scene, pass);
-                if (m_RenderCallback) {
-                    m_RenderCallback(tile.x, tile.y, tile.w, tile.h);
-                }
-            });
+        // Set by the first tile whose next block does not fit the budget, so cheap tiles do not run on alone
+        std::atomic<bool> budgetReached { false };
 
-            JobSystem::Sync();
+        // Seconds of each tile's last block, and their sum over the tiles not done yet, the queue a requeued block waits in
+        std::vector<f32> tileBlockSeconds(totalTiles, 0.0f);
+        std::atomic<f64> queueSeconds { 0.0 };
+        const u32 workers = JobSystem::GetWorkerCount() + 1;
 
-            if (m_CancelRender) {
-                LOG_WARN("In-progress render cancelled");
+        auto start = std::chrono::steady_clock::now();
+
+        auto finishPass = [&](u32 pass, bool rendered) {
+            u32 rendering = rendered ? passRendered[pass - 1].fetch_add(1) + 1 : passRendered[pass - 1].load();
+            if (passTiles[pass - 1].fetch_add(1) + 1 != totalTiles || rendering == 0) return;
+
+            std::chrono::duration<f32> elapsed = std::chrono::steady_clock::now() - start;
+            LOG_INFO("Pass [{}/{}] | done at {:.2f} seconds | {}/{} tiles", pass, spp, elapsed.count(), passRendered[pass - 1].load(), totalTiles);
+        };
+
+        auto finishTile = [&](u32 tileIndex, bool converged) {
+            tileConverged[tileIndex] = converged ? 1 : 0;
+            for (u32 pass = tileSamples[tileIndex] + 1; pass <= spp; ++pass) {
+                finishPass(pass, false);
+            }
+            queueSeconds.fetch_sub(tileBlockSeconds[tileIndex]);
+        };
+
+        // Each tile is one job rendering a block of samples that requeues itself behind the other tiles,
+        // so a slow tile only holds back its own next block instead of every core at the end of a pass
+        JobContext context;
+        std::function<void(u32)> renderBlock = [&](u32 tileIndex) {
+            if (m_CancelRender) return;
+
+            const Tile& tile = tiles[tileIndex];
+            u32 first = tileSamples[tileIndex];
+            u32 last = std::min(first + blockSamples, spp);
+
+            // The budget may have run out while the block waited in the queue, the tile's last block was a full one
+            // and takes at least as long as this one
+            if (budgetReached || !budget.Fits(tileBlockSeconds[tileIndex])) {
+                budgetReached = true;
+                finishTile(tileIndex, false);
                 return;
             }
 
-            auto end = std::chrono::steady_clock::now();
-            std::chrono::duration<f32> duration = end - start;
+            auto blockStart = std::chrono::steady_clock::now();
+
+            bool converged = false;
+            for (u32 pass = first + 1; pass <= last && !converged; ++pass) {
+                converged = RenderTile(tile, scene, pass);
+                tileSamples[tileIndex] = pass;
+                finishPass(pass, true);
+            }
+
+            std::chrono::duration<f32> block = std::chrono::steady_clock::now() - blockStart;
+
+            if (m_RenderCallback) {
+                m_RenderCallback(tile.x, tile.y, tile.w, tile.h);
+            }
+
+            u32 done = tileSamples[tileIndex];
+            u32 next = std::min(blockSamples, spp - done);
+
+            queueSeconds.fetch_add(block.count() - tileBlockSeconds[tileIndex]);
+            tileBlockSeconds[tileIndex] = block.count();
+
+            // The next block starts once every tile queued ahead ran its block again on the workers
+            f32 queued = static_cast<f32>(queueSeconds.load() - block.count()) / static_cast<f32>(workers);
+            f32 predicted = queued + block.count() / static_cast<f32>(done - first) * static_cast<f32>(next);
+            if (!budget.Fits(predicted)) {
+                budgetReached = true;
+            }
+
+            if (done < spp && !converged && !m_CancelRender && !budgetReached) {
+                JobSystem::Execute(context, [&renderBlock, tileIndex]() { renderBlock(tileIndex); });
+                return;
+            }
+
+            finishTile(tileIndex, converged);
+        };
+
+        JobSystem::Dispatch(context, totalTiles, 1, [&](JobDispatchArgs args) {
+            renderBlock(args.jobIndex);
+        });
 
-            LOG_INFO("Pass [{}/{}] | {:.2f} seconds", pass, sampler->GetSPP(), duration.count());
+        JobSystem::Wait(context);
+
+        if (m_CancelRender) {
+            LOG_WARN("In-progress render cancelled");
+            return;
+        }
+
+        auto [minSamples, maxSamples] = std::minmax_element(tileSamples.begin(), tileSamples.end());
+
+        if (adaptive && std::ranges::all_of(tileConverged, [](u8 converged) { return converged != 0; })) {
+            LOG_INFO("Every pixel converged after {} passes", *maxSamples);
+        }
+
+        if (adaptive) {
+            const Film& film = camera->GetFilm();
+            f64 samples = static_cast<f64>(film.GetTotalSampleCount());
+            f64 pixels = static_cast<f64>(width) * height;
+
+            LOG_INFO("Adaptive Sampling Metrics");
+            LOG_INFO(" - Threshold: {:.4f} relative error after {} samples", m_Config.adaptiveThreshold, m_Config.adaptiveMinSamples);
+            LOG_INFO(" - Samples: {:.2f} per pixel, {:.1f}% of the fixed budget", samples / pixels, 100.0 * samples / (pixels * spp));
+        }
+
+        if (budgetReached) {
+            LOG_INFO("Time budget reached with tiles at {} to {} samples", *minSamples, *maxSamples);
+        }
+
+        if (budget.IsEnabled()) {
+            f32 elapsed = budget.GetElapsed();
+
+            LOG_INFO("Time Budget Metrics");
+            LOG_INFO(" - Budget: {:.2f} seconds", budget.GetSeconds());
+            LOG_INFO(" - Used: {:.2f} seconds ({:.1f}%)", elapsed, 100.0f * elapsed / budget.GetSeconds());
+            LOG_INFO(" - Passes: {} to {} of {} per tile", *minSamples, *maxSamples, spp);
         }
 
         camera->GetFilm().Write(m_Config.output);
     }
 
-    void RandomWalkIntegrator::RenderTile(const Tile& tile, const Scene& scene, u32 sample)
+    bool RandomWalkIntegrator::RenderTile(const Tile& tile, const Scene& scene, u32 sample)
     {
         const auto& camera = m_Config.camera;
         auto sampler = m_Config.sampler->Clone();
 
+        Film& film = camera->GetFilm();
+        const bool adaptive = m_Config.adaptiveThreshold > 0.0f;
+        bool converged = adaptive;
+
         for (u32 y = tile.y; y < tile.y + tile.h; ++y) {
             for (u32 x = tile.x; x < tile.x + tile.w; ++x) {
+                if (adaptive && film.IsConverged(x, y, m_Config.adaptiveThreshold, m_Config.adaptiveMinSamples)) continue;
+
                 sampler->StartPixel(x, y, sample);
 
                 CameraSample cs;
@@ -104,9 +209,15 @@ namespace Silmaril {
 
                 glm::vec3 L = Li(ray, scene, *sampler, 0);
 
-                camera->GetFilm().AccumulateSample(x, y, L, sample);
+                film.AccumulateSample(x, y, L);
+
+                if (adaptive && !film.IsConverged(x, y, m_Config.adaptiveThreshold, m_Config.adaptiveMinSamples)) {
+                    converged = false;
+                }
             }
         }
+
+        return converged;
     }
 
     glm::vec3 RandomWalkIntegrator::Li(
@@ -116,7 +227,9 @@ namespace Silmaril {
         u32 depth,
         glm::vec3 beta,
         f32 prevPdfBSDF,
-        bool prevIsDelta
+        bool prevIsDelta,
+        const glm::vec3& prevP,
+        const glm::vec3& prevN
     )
     {
         if (depth >= m_Config.depth) return glm::vec3(0.0f);
@@ -126,17 +239,31 @@ namespace Silmaril {
 
         SurfaceInteraction intersect;
         if (!scene.Intersect(r, intersect)) {
-            // Skybox
-            f32 t = 0.5f * (glm::normalize(r.direction).y + 1.0f);
-            glm::vec3 sky = glm::mix(glm::vec3(1.0f), glm::vec3(0.5f, 0.7f, 1.0f), t);
+            if (scene.GetInfiniteLights().empty()) return beta * Sky(r.direction);
+
+            for (const Light* light : scene.GetInfiniteLights()) {
+                glm::vec3 Le = light->Le(r);
+
+                if (depth == 0 || prevIsDelta) {
+                    L += beta * Le;
+                } else {
+                    Interaction prev;
+                    prev.p = r.origin;
 
-            return beta * sky;
+                    f32 lightPdf = scene.LightPMF(prevP, prevN, light) * light->PdfLi(prev, r.direction);
+                    f32 weight = PowerHeuristic(prevPdfBSDF, lightPdf);
+
+                    L += beta * Le * weight;
+                }
+            }
+
+            return L;
         }
 
         glm::vec3 wo = -r.direction;
 
-        if (intersect.primitive->GetLight()) {
-            const Light* light = intersect.primitive->GetLight();
+        if (intersect.light) {
+            const Light* light = intersect.light;
             glm::vec3 Le = light->L(intersect, wo);
 
             if (depth == 0 || prevIsDelta) {
@@ -145,38 +272,31 @@ namespace Silmaril {
                 Interaction prev;
                 prev.p = r.origin;
 
-                f32 lightPdf = light->PdfLi(prev, intersect);
+                f32 lightPdf = scene.LightPMF(prevP, prevN, light) * light->PdfLi(prev, intersect);
                 f32 weight = PowerHeuristic(prevPdfBSDF, lightPdf);
 
                 L += beta * Le * weight;
             }
         }
 
-        const Material* material = intersect.primitive->GetMaterial();
+        const Material* material = intersect.material;
         if (!material) return L;
 
         material->ComputeScatterFn(intersect);
         if (!intersect.bsdf) return L;
 
         // Direct Light
-        const auto& lights = scene.GetLights();
-        if (!lights.empty()) {
-            u32 lightIdx = std::min(static_cast<u32>(sampler.Get1D() * lights.size()), static_cast<u32>(lights.size()) - 1);
-            const auto& light = lights[lightIdx];
-
-            f32 lightSelectPdf = 1.0f / lights.size();
-
+        f32 lightSelectPdf = 0.0f;
+        if (const Light* light = scene.SampleLight(intersect.p, intersect.shading.n, sampler.Get1D(), lightSelectPdf)) {
             auto ls = light->SampleLi(intersect, sampler.Get2D());
 
             if (ls && ls->pdf > 0.0f && ls->distance > 0.0f && !glm::isinf(ls->pdf)) {
                 glm::vec3 wi = ls->wi;
-                f32 lightPdf = ls->pdf / lightSelectPdf;
+                f32 lightPdf = ls->pdf * lightSelectPdf;
 
                 Ray shadowRay = intersect.SpawnRay(wi);
-                SurfaceInteraction shadowIntersect;
-                bool hit = scene.Intersect(shadowRay, shadowIntersect);
 
-                if (!hit || shadowIntersect.t > ls->distance - 0.001f) {
+                if (!scene.IntersectP(shadowRay, ls->distance - 0.001f)) {
                     glm::vec3 f = intersect.bsdf->f(wo, wi);
                     if (glm::length(f) > 0.0f) {
                         f32 bsdfPdf = intersect.bsdf->Pdf(wo, wi);
@@ -210,7 +330,7 @@ namespace Silmaril {
             Ray nextRay = intersect.SpawnRay(bs->wi);
             bool isSpecular = (bs->pdf > 1e5f);
 
-            L += Li(nextRay, scene, sampler, depth + 1, nextBeta, bs->pdf, isSpecular);
+            L += Li(nextRay, scene, sampler, depth + 1, nextBeta, bs->pdf, isSpecular, intersect.p, intersect.shading.n);
         }
 
         return L;
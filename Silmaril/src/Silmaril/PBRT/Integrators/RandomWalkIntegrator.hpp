@@ -21,6 +21,19 @@ namespace Silmaril {
             u32 tile;
 
             std::string output;
+
+            // Adaptive sampling: a pixel stops once the standard error of its mean luminance falls below
+            // this fraction of the mean, 0 gives every pixel the full sample count
+            f32 adaptiveThreshold { 0.0f };
+            // Samples every pixel takes before its error estimate is trusted
+            u32 adaptiveMinSamples { 16 };
+
+            // Wall-clock seconds the render may take: a tile stops once its next block is predicted not to fit,
+            // 0 renders every pass
+            f32 timeBudget { 0.0f };
+
+            // Samples a tile job renders before requeueing itself behind the other tiles
+            u32 tileSamples { 1 };
         };
     public:
         RandomWalkIntegrator(const Config& config);
@@ -38,7 +51,8 @@ namespace Silmaril {
         };
 
     private:
-        void RenderTile(const Tile& tile, const Scene& scene, u32 sample);
+        // Returns true once every pixel of the tile converged, always false without adaptive sampling
+        bool RenderTile(const Tile& tile, const Scene& scene, u32 sample);
         glm::vec3 Li(
             const Ray& ray,
             const Scene& scene,
@@ -46,7 +60,10 @@ namespace Silmaril {
             u32 depth,
             glm::vec3 beta = glm::vec3(1.0f),
             f32 prevPdfBSDF = 0.0f,
-            bool prevIsDelta = false
+            bool prevIsDelta = false,
+            // Shading point and normal of the previous bounce, for the light selection pmf
+            const glm::vec3& prevP = glm::vec3(0.0f),
+            const glm::vec3& prevN = glm::vec3(0.0f)
         );
 
     private:
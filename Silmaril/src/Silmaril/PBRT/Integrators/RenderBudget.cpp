@@ -0,0 +1,46 @@
+#include "RenderBudget.hpp"
+
+namespace Silmaril {
+
+    RenderBudget::RenderBudget(f32 seconds)
+        :   m_Seconds(seconds),
+            m_Start(std::chrono::steady_clock::now())
+    {
+    }
+
+    f32 RenderBudget::GetElapsed() const
+    {
+        std::chrono::duration<f32> elapsed = std::chrono::steady_clock::now() - m_Start;
+        return elapsed.count();
+    }
+
+    void RenderBudget::RecordPass(f32 seconds, u32 tiles)
+    {
+        if (tiles == 0) return;
+
+        m_LastTile = static_cast<f64>(seconds) / tiles;
+
+        m_Passes++;
+        f64 delta = m_LastTile - m_TileMean;
+        m_TileMean += delta / m_Passes;
+        m_TileM2 += delta * (m_LastTile - m_TileMean);
+    }
+
+    f32 RenderBudget::PredictPass(u32 tiles) const
+    {
+        if (m_Passes == 0) return 0.0f;
+
+        f64 deviation = m_Passes > 1 ? std::sqrt(m_TileM2 / (m_Passes - 1)) : 0.0;
+        f64 perTile = std::max(m_LastTile, m_TileMean + 2.0 * deviation);
+
+        return static_cast<f32>(perTile * tiles);
+    }
+
+    bool RenderBudget::Fits(f32 seconds) const
+    {
+        if (!IsEnabled()) return true;
+
+        return GetElapsed() + seconds <= m_Seconds;
+    }
+
+}
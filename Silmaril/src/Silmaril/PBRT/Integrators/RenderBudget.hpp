@@ -0,0 +1,39 @@
+#pragma once
+
+namespace Silmaril {
+
+    // Wall-clock limit on a render, checked before more work starts against the predicted cost of that work.
+    // Passes are timed per tile, so a pass over fewer tiles (adaptive sampling) is predicted shorter.
+    class RenderBudget
+    {
+    public:
+        // Starts the clock, 0 seconds disables the budget
+        RenderBudget(f32 seconds);
+
+        inline bool IsEnabled() const { return m_Seconds > 0.0f; }
+        inline f32 GetSeconds() const { return m_Seconds; }
+
+        f32 GetElapsed() const;
+
+        void RecordPass(f32 seconds, u32 tiles);
+
+        // The slower of the last pass and the mean plus two deviations of every pass, per tile
+        f32 PredictPass(u32 tiles) const;
+
+        // False once work taking the given seconds would end past the budget, always true while disabled
+        bool Fits(f32 seconds) const;
+
+        inline bool FitsPass(u32 tiles) const { return Fits(PredictPass(tiles)); }
+
+    private:
+        f32 m_Seconds { 0.0f };
+        std::chrono::steady_clock::time_point m_Start;
+
+        // Welford running mean and sum of squared deviations of the seconds per tile
+        u32 m_Passes { 0 };
+        f64 m_TileMean { 0.0 };
+        f64 m_TileM2 { 0.0 };
+        f64 m_LastTile { 0.0 };
+    };
+
+}
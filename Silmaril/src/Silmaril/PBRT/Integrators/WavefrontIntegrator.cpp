@@ -0,0 +1,455 @@
+#include "WavefrontIntegrator.hpp"
+#include "RenderBudget.hpp"
+
+#include "Silmaril/PBRT/Cameras/Camera.hpp"
+#include "Silmaril/PBRT/Samplers/Sampler.hpp"
+#include "Silmaril/PBRT/Scene/Scene.hpp"
+#include "Silmaril/PBRT/Materials/Material.hpp"
+#include "Silmaril/PBRT/Materials/BSDF.hpp"
+
+#include "Silmaril/Core/Logger.hpp"
+#include "Silmaril/Core/JobSystem.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        // Paths per job of a stage dispatch
+        constexpr u32 s_StageBatch = 256;
+
+    }
+
+    void WavefrontIntegrator::PathStates::Resize(u32 size, const Sampler& prototype)
+    {
+        pixel.resize(size);
+        traced.resize(size);
+
+        rayOrigin.resize(size);
+        rayDirection.resize(size);
+
+        beta.resize(size);
+        L.resize(size);
+        prevPdfBSDF.resize(size);
+        prevIsDelta.resize(size);
+        prevP.resize(size);
+        prevN.resize(size);
+
+        hit.resize(size);
+        surface.resize(size);
+
+        sampler.resize(size);
+        for (auto& s : sampler) {
+            s = prototype.Clone();
+        }
+
+        shadowOrigin.resize(size);
+        shadowDirection.resize(size);
+        shadowDistance.resize(size);
+        shadowLi.resize(size);
+
+        hasShadowRay.resize(size);
+        continues.resize(size);
+    }
+
+    WavefrontIntegrator::WavefrontIntegrator(const Config& config)
+        :   Integrator(config.tile),
+            m_Config(config)
+    {
+    }
+
+    void WavefrontIntegrator::Render(const Scene& scene)
+    {
+        m_CancelRender = false;
+
+        RenderBudget budget(m_Config.timeBudget);
+
+        const auto& camera = m_Config.camera;
+        const auto& sampler = m_Config.sampler;
+
+        camera->GetFilm().Clear();
+
+        u32 width = camera->GetFilm().GetWidth();
+        u32 height = camera->GetFilm().GetHeight();
+
+        u32 tilesX = (width + m_TileSize - 1) / m_TileSize;
+        u32 tilesY = (height + m_TileSize - 1) / m_TileSize;
+        u32 totalTiles = tilesX * tilesY;
+
+        std::vector<Tile> tiles;
+        tiles.reserve(totalTiles);
+
+        for (u32 y = 0; y < tilesY; ++y) {
+            for (u32 x = 0; x < tilesX; ++x) {
+                u32 x0 = x * m_TileSize;
+                u32 y0 = y * m_TileSize;
+                u32 x1 = std::min(x0 + m_TileSize, width);
+                u32 y1 = std::min(y0 + m_TileSize, height);
+                tiles.push_back({ x0, y0, x1 - x0, y1 - y0 });
+            }
+        }
+
+        u32 tilePixels = m_TileSize * m_TileSize;
+        u32 tilesPerChunk = std::clamp(m_Config.pathPool / tilePixels, 1u, totalTiles);
+        m_Paths.Resize(tilesPerChunk * tilePixels, *sampler);
+
+        LOG_INFO("Rendering {} tiles ({}x{}) for {} samples", totalTiles, m_TileSize, m_TileSize, sampler->GetSPP());
+        LOG_INFO(" - Wavefront: {} paths in flight ({} tiles per chunk)", tilesPerChunk * tilePixels, tilesPerChunk);
+
+        Film& film = camera->GetFilm();
+        const bool adaptive = m_Config.adaptiveThreshold > 0.0f;
+
+        // Tiles whose pixels all converged drop out of later passes
+        std::vector<u32> activeTiles(tiles.size());
+        std::iota(activeTiles.begin(), activeTiles.end(), 0u);
+        std::vector<u8> tileConverged(tiles.size(), 0);
+
+        std::vector<Tile> chunk;
+        chunk.reserve(tilesPerChunk);
+
+        u32 passes = 0;
+        for (u32 pass = 1; pass < (sampler->GetSPP() + 1); ++pass) {
+            u32 passTiles = static_cast<u32>(activeTiles.size());
+            if (!budget.FitsPass(passTiles)) {
+                LOG_INFO("Time budget reached after {} passes, the next is predicted at {:.2f} seconds with {:.2f} left",
+                    passes, budget.PredictPass(passTiles), budget.GetSeconds() - budget.GetElapsed());
+                break;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+
+            for (usize first = 0; first < activeTiles.size() && !m_CancelRender; first += tilesPerChunk) {
+                usize last = std::min<usize>(first + tilesPerChunk, activeTiles.size());
+
+                chunk.clear();
+                for (usize i = first; i < last; ++i) {
+                    chunk.push_back(tiles[activeTiles[i]]);
+                }
+
+                RenderChunk(chunk, scene, pass);
+
+                if (adaptive) {
+                    JobContext context;
+                    JobSystem::Dispatch(context, static_cast<u32>(chunk.size()), 1, [&](JobDispatchArgs args) {
+                        const Tile& tile = chunk[args.jobIndex];
+
+                        u8 converged = 1;
+                        for (u32 y = tile.y; y < tile.y + tile.h && converged; ++y) {
+                            for (u32 x = tile.x; x < tile.x + tile.w && converged; ++x) {
+                                converged = film.IsConverged(x, y, m_Config.adaptiveThreshold, m_Config.adaptiveMinSamples) ? 1 : 0;
+                            }
+                        }
+
+                        tileConverged[activeTiles[first + args.jobIndex]] = converged;
+                    });
+                    JobSystem::Wait(context);
+                }
+
+                if (m_RenderCallback) {
+                    for (const Tile& tile : chunk) {
+                        m_RenderCallback(tile.x, tile.y, tile.w, tile.h);
+                    }
+                }
+            }
+
+            if (m_CancelRender) {
+                LOG_WARN("In-progress render cancelled");
+                return;
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            std::chrono::duration<f32> duration = end - start;
+
+            budget.RecordPass(duration.count(), passTiles);
+            passes++;
+
+            if (adaptive) {
+                LOG_INFO("Pass [{}/{}] | {:.2f} seconds | {}/{} tiles", pass, sampler->GetSPP(), duration.count(), activeTiles.size(), totalTiles);
+
+                std::erase_if(activeTiles, [&](u32 tileIndex) { return tileConverged[tileIndex] != 0; });
+                if (activeTiles.empty()) {
+                    LOG_INFO("Every pixel converged after {} passes", pass);
+                    break;
+                }
+            } else {
+                LOG_INFO("Pass [{}/{}] | {:.2f} seconds", pass, sampler->GetSPP(), duration.count());
+            }
+        }
+
+        if (adaptive) {
+            f64 samples = static_cast<f64>(film.GetTotalSampleCount());
+            f64 pixels = static_cast<f64>(width) * height;
+
+            LOG_INFO("Adaptive Sampling Metrics");
+            LOG_INFO(" - Threshold: {:.4f} relative error after {} samples", m_Config.adaptiveThreshold, m_Config.adaptiveMinSamples);
+            LOG_INFO(" - Samples: {:.2f} per pixel, {:.1f}% of the fixed budget", samples / pixels, 100.0 * samples / (pixels * sampler->GetSPP()));
+        }
+
+        if (budget.IsEnabled()) {
+            f32 elapsed = budget.GetElapsed();
+
+            LOG_INFO("Time Budget Metrics");
+            LOG_INFO(" - Budget: {:.2f} seconds", budget.GetSeconds());
+            LOG_INFO(" - Used: {:.2f} seconds ({:.1f}%)", elapsed, 100.0f * elapsed / budget.GetSeconds());
+            LOG_INFO(" - Passes: {} of {}", passes, sampler->GetSPP());
+        }
+
+        camera->GetFilm().Write(m_Config.output);
+    }
+
+    void WavefrontIntegrator::RenderChunk(const std::vector<Tile>& chunk, const Scene& scene, u32 sample)
+    {
+        GenerateCameraRays(chunk, sample);
+
+        for (u32 depth = 0; depth < m_Config.depth && !m_ActiveQueue.empty(); ++depth) {
+            if (m_CancelRender) return;
+
+            ExtendPaths(scene, depth);
+            ShadePaths(scene, depth);
+            TraceShadowRays(scene);
+
+            m_ActiveQueue.clear();
+            for (u32 slot : m_HitQueue) {
+                if (m_Paths.continues[slot]) m_ActiveQueue.push_back(slot);
+            }
+        }
+
+        AccumulatePaths();
+    }
+
+    void WavefrontIntegrator::GenerateCameraRays(const std::vector<Tile>& chunk, u32 sample)
+    {
+        const auto& camera = m_Config.camera;
+        const Film& film = camera->GetFilm();
+        const bool adaptive = m_Config.adaptiveThreshold > 0.0f;
+
+        // Slots are handed out tile by tile, so neighbouring slots hold neighbouring pixels
+        std::vector<u32> tileSlots(chunk.size());
+        m_PathCount = 0;
+        for (usize i = 0; i < chunk.size(); ++i) {
+            tileSlots[i] = m_PathCount;
+            m_PathCount += chunk[i].w * chunk[i].h;
+        }
+
+        JobContext context;
+        JobSystem::Dispatch(context, static_cast<u32>(chunk.size()), 1, [&](JobDispatchArgs args) {
+            const Tile& tile = chunk[args.jobIndex];
+            u32 slot = tileSlots[args.jobIndex];
+
+            for (u32 y = tile.y; y < tile.y + tile.h; ++y) {
+                for (u32 x = tile.x; x < tile.x + tile.w; ++x, ++slot) {
+                    m_Paths.pixel[slot] = glm::uvec2(x, y);
+                    m_Paths.traced[slot] = adaptive && film.IsConverged(x, y, m_Config.adaptiveThreshold, m_Config.adaptiveMinSamples) ? 0 : 1;
+                    if (!m_Paths.traced[slot]) continue;
+
+                    Sampler& sampler = *m_Paths.sampler[slot];
+                    sampler.StartPixel(x, y, sample);
+
+                    CameraSample cs;
+                    cs.pFilm = glm::vec2(x, y) + sampler.Get2D();
+
+                    Ray ray = camera->GenerateRay(cs);
+
+                    m_Paths.rayOrigin[slot] = ray.origin;
+                    m_Paths.rayDirection[slot] = ray.direction;
+                    m_Paths.beta[slot] = glm::vec3(1.0f);
+                    m_Paths.L[slot] = glm::vec3(0.0f);
+                    m_Paths.prevPdfBSDF[slot] = 0.0f;
+                    m_Paths.prevIsDelta[slot] = 0;
+                }
+            }
+        });
+        JobSystem::Wait(context);
+
+        m_ActiveQueue.clear();
+        for (u32 slot = 0; slot < m_PathCount; ++slot) {
+            if (m_Paths.traced[slot]) m_ActiveQueue.push_back(slot);
+        }
+    }
+
+    void WavefrontIntegrator::ExtendPaths(const Scene& scene, u32 depth)
+    {
+        JobContext context;
+        JobSystem::Dispatch(context, static_cast<u32>(m_ActiveQueue.size()), s_StageBatch, [&](JobDispatchArgs args) {
+            u32 slot = m_ActiveQueue[args.jobIndex];
+
+            Ray ray(m_Paths.rayOrigin[slot], m_Paths.rayDirection[slot]);
+
+            HitInteraction& hit = m_Paths.hit[slot];
+            hit = HitInteraction();
+
+            if (!scene.Intersect(ray, hit)) {
+                hit.primitive = nullptr;
+
+                if (scene.GetInfiniteLights().empty()) {
+                    m_Paths.L[slot] += m_Paths.beta[slot] * Sky(ray.direction);
+                }
+
+                for (const Light* light : scene.GetInfiniteLights()) {
+                    glm::vec3 Le = light->Le(ray);
+
+                    if (depth == 0 || m_Paths.prevIsDelta[slot]) {
+                        m_Paths.L[slot] += m_Paths.beta[slot] * Le;
+                    } else {
+                        Interaction prev;
+                        prev.p = ray.origin;
+
+                        f32 lightPdf = scene.LightPMF(m_Paths.prevP[slot], m_Paths.prevN[slot], light) * light->PdfLi(prev, ray.direction);
+                        f32 weight = PowerHeuristic(m_Paths.prevPdfBSDF[slot], lightPdf);
+
+                        m_Paths.L[slot] += m_Paths.beta[slot] * Le * weight;
+                    }
+                }
+            }
+
+            m_Paths.hasShadowRay[slot] = 0;
+            m_Paths.continues[slot] = 0;
+        });
+        JobSystem::Wait(context);
+
+        m_HitQueue.clear();
+        for (u32 slot : m_ActiveQueue) {
+            if (m_Paths.hit[slot].primitive) m_HitQueue.push_back(slot);
+        }
+    }
+
+    void WavefrontIntegrator::ShadePaths(const Scene& scene, u32 depth)
+    {
+        JobContext context;
+        JobSystem::Dispatch(context, static_cast<u32>(m_HitQueue.size()), s_StageBatch, [&](JobDispatchArgs args) {
+            u32 slot = m_HitQueue[args.jobIndex];
+
+            Ray ray(m_Paths.rayOrigin[slot], m_Paths.rayDirection[slot]);
+            const HitInteraction& hit = m_Paths.hit[slot];
+
+            SurfaceInteraction& intersect = m_Paths.surface[slot];
+            intersect = SurfaceInteraction();
+            hit.primitive->FillSurfaceInteraction(ray, hit, intersect);
+
+            if (intersect.light) {
+                const Light* light = intersect.light;
+                glm::vec3 Le = light->L(intersect, -ray.direction);
+
+                if (depth == 0 || m_Paths.prevIsDelta[slot]) {
+                    m_Paths.L[slot] += m_Paths.beta[slot] * Le;
+                } else {
+                    Interaction prev;
+                    prev.p = ray.origin;
+
+                    f32 lightPdf = scene.LightPMF(m_Paths.prevP[slot], m_Paths.prevN[slot], light) * light->PdfLi(prev, intersect);
+                    f32 weight = PowerHeuristic(m_Paths.prevPdfBSDF[slot], lightPdf);
+
+                    m_Paths.L[slot] += m_Paths.beta[slot] * Le * weight;
+                }
+            }
+        });
+        JobSystem::Wait(context);
+
+        // Paths on the same material shade next to each other, surfaces without one end here
+        std::erase_if(m_HitQueue, [&](u32 slot) { return !m_Paths.surface[slot].material; });
+        std::stable_sort(m_HitQueue.begin(), m_HitQueue.end(), [&](u32 a, u32 b) {
+            return std::less<const Material*>()(m_Paths.surface[a].material, m_Paths.surface[b].material);
+        });
+
+        JobSystem::Dispatch(context, static_cast<u32>(m_HitQueue.size()), s_StageBatch, [&](JobDispatchArgs args) {
+            u32 slot = m_HitQueue[args.jobIndex];
+
+            SurfaceInteraction& intersect = m_Paths.surface[slot];
+            Sampler& sampler = *m_Paths.sampler[slot];
+
+            intersect.material->ComputeScatterFn(intersect);
+            if (!intersect.bsdf) return;
+
+            glm::vec3 wo = -m_Paths.rayDirection[slot];
+            glm::vec3 beta = m_Paths.beta[slot];
+
+            // Direct Light, traced later with the other shadow rays of this bounce
+            f32 lightSelectPdf = 0.0f;
+            if (const Light* light = scene.SampleLight(intersect.p, intersect.shading.n, sampler.Get1D(), lightSelectPdf)) {
+                auto ls = light->SampleLi(intersect, sampler.Get2D());
+
+                if (ls && ls->pdf > 0.0f && ls->distance > 0.0f && !glm::isinf(ls->pdf)) {
+                    glm::vec3 wi = ls->wi;
+                    f32 lightPdf = ls->pdf * lightSelectPdf;
+
+                    glm::vec3 f = intersect.bsdf->f(wo, wi);
+                    if (glm::length(f) > 0.0f) {
+                        f32 bsdfPdf = intersect.bsdf->Pdf(wo, wi);
+                        f32 weight = light->IsDelta() ? 1.0f : PowerHeuristic(lightPdf, bsdfPdf);
+
+                        Ray shadowRay = intersect.SpawnRay(wi);
+
+                        m_Paths.shadowOrigin[slot] = shadowRay.origin;
+                        m_Paths.shadowDirection[slot] = shadowRay.direction;
+                        m_Paths.shadowDistance[slot] = ls->distance - 0.001f;
+                        m_Paths.shadowLi[slot] = beta * f * ls->li * glm::abs(glm::dot(intersect.shading.n, wi)) * weight / lightPdf;
+                        m_Paths.hasShadowRay[slot] = 1;
+                    }
+                }
+            }
+
+            // BSDF Sampling
+            auto bs = intersect.bsdf->SampleF(wo, sampler.Get2D());
+            if (!bs || bs->pdf <= 0) return;
+
+            glm::vec3 f = bs->f * glm::abs(glm::dot(intersect.shading.n, bs->wi));
+            if (glm::length(f) == 0.0f) return;
+
+            glm::vec3 nextBeta = beta * f / bs->pdf;
+
+            if (depth > 3) {
+                f32 maxBeta = std::max({ nextBeta.r, nextBeta.g, nextBeta.b });
+                f32 q = std::max(0.05f, 1.0f - maxBeta);
+
+                if (sampler.Get1D() < q) return;
+
+                nextBeta /= 1.0f - q;
+            }
+
+            Ray nextRay = intersect.SpawnRay(bs->wi);
+
+            m_Paths.rayOrigin[slot] = nextRay.origin;
+            m_Paths.rayDirection[slot] = nextRay.direction;
+            m_Paths.beta[slot] = nextBeta;
+            m_Paths.prevPdfBSDF[slot] = bs->pdf;
+            m_Paths.prevIsDelta[slot] = bs->pdf > 1e5f ? 1 : 0;
+            m_Paths.prevP[slot] = intersect.p;
+            m_Paths.prevN[slot] = intersect.shading.n;
+            m_Paths.continues[slot] = 1;
+        });
+        JobSystem::Wait(context);
+    }
+
+    void WavefrontIntegrator::TraceShadowRays(const Scene& scene)
+    {
+        m_ShadowQueue.clear();
+        for (u32 slot : m_HitQueue) {
+            if (m_Paths.hasShadowRay[slot]) m_ShadowQueue.push_back(slot);
+        }
+
+        JobContext context;
+        JobSystem::Dispatch(context, static_cast<u32>(m_ShadowQueue.size()), s_StageBatch, [&](JobDispatchArgs args) {
+            u32 slot = m_ShadowQueue[args.jobIndex];
+
+            Ray shadowRay(m_Paths.shadowOrigin[slot], m_Paths.shadowDirection[slot]);
+            if (!scene.IntersectP(shadowRay, m_Paths.shadowDistance[slot])) {
+                m_Paths.L[slot] += m_Paths.shadowLi[slot];
+            }
+        });
+        JobSystem::Wait(context);
+    }
+
+    void WavefrontIntegrator::AccumulatePaths()
+    {
+        Film& film = m_Config.camera->GetFilm();
+
+        JobContext context;
+        JobSystem::Dispatch(context, m_PathCount, s_StageBatch, [&](JobDispatchArgs args) {
+            if (!m_Paths.traced[args.jobIndex]) return;
+
+            const glm::uvec2& pixel = m_Paths.pixel[args.jobIndex];
+            film.AccumulateSample(pixel.x, pixel.y, m_Paths.L[args.jobIndex]);
+        });
+        JobSystem::Wait(context);
+    }
+
+}
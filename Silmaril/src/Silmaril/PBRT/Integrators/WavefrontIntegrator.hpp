@@ -0,0 +1,110 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Integrator.hpp"
+#include "Silmaril/PBRT/Containers/Interaction.hpp"
+
+namespace Silmaril {
+
+    class Camera;
+    class Sampler;
+
+    // Traces a pool of paths breadth-first, one stage at a time over every live path: generate camera rays,
+    // extend to the closest hit, shade grouped by material, trace the batched shadow rays, accumulate.
+    // Estimates the same integral as RandomWalkIntegrator with the same sample sequence per pixel.
+    class WavefrontIntegrator final : public Integrator
+    {
+    public:
+        struct Config
+        {
+            std::shared_ptr<Camera> camera;
+            std::shared_ptr<Sampler> sampler;
+            u32 depth;
+            u32 tile;
+
+            std::string output;
+
+            // Adaptive sampling, as in RandomWalkIntegrator::Config
+            f32 adaptiveThreshold { 0.0f };
+            u32 adaptiveMinSamples { 16 };
+
+            // Wall-clock seconds the render may take: passes stop once the next one is predicted not to fit,
+            // 0 renders every pass
+            f32 timeBudget { 0.0f };
+
+            // Paths in flight at once, rounded to whole tiles
+            u32 pathPool { 1 << 18 };
+        };
+
+    public:
+        WavefrontIntegrator(const Config& config);
+        virtual ~WavefrontIntegrator() = default;
+
+        virtual void Render(const Scene& scene) override;
+
+    private:
+        struct Tile
+        {
+            u32 x;
+            u32 y;
+            u32 w;
+            u32 h;
+        };
+
+        // Per path state, one entry per pool slot in every array
+        struct PathStates
+        {
+            std::vector<glm::uvec2> pixel;
+            // Cleared for converged pixels, their slot stays idle for the chunk
+            std::vector<u8> traced;
+
+            std::vector<glm::vec3> rayOrigin;
+            std::vector<glm::vec3> rayDirection;
+
+            std::vector<glm::vec3> beta;
+            std::vector<glm::vec3> L;
+            std::vector<f32> prevPdfBSDF;
+            std::vector<u8> prevIsDelta;
+            std::vector<glm::vec3> prevP;
+            std::vector<glm::vec3> prevN;
+
+            std::vector<HitInteraction> hit;
+            std::vector<SurfaceInteraction> surface;
+            std::vector<std::unique_ptr<Sampler>> sampler;
+
+            // Shadow ray of the current bounce and the radiance it carries when unoccluded
+            std::vector<glm::vec3> shadowOrigin;
+            std::vector<glm::vec3> shadowDirection;
+            std::vector<f32> shadowDistance;
+            std::vector<glm::vec3> shadowLi;
+
+            // Stage results, read when the queues are rebuilt between stages
+            std::vector<u8> hasShadowRay;
+            std::vector<u8> continues;
+
+            void Resize(u32 size, const Sampler& prototype);
+        };
+
+    private:
+        void RenderChunk(const std::vector<Tile>& chunk, const Scene& scene, u32 sample);
+
+        void GenerateCameraRays(const std::vector<Tile>& chunk, u32 sample);
+        void ExtendPaths(const Scene& scene, u32 depth);
+        void ShadePaths(const Scene& scene, u32 depth);
+        void TraceShadowRays(const Scene& scene);
+        void AccumulatePaths();
+
+    private:
+        Config m_Config;
+
+        PathStates m_Paths;
+        u32 m_PathCount { 0 };
+
+        // Slots of the live paths, the paths that hit a surface sorted by material, and the paths with a shadow ray
+        std::vector<u32> m_ActiveQueue;
+        std::vector<u32> m_HitQueue;
+        std::vector<u32> m_ShadowQueue;
+    };
+
+}
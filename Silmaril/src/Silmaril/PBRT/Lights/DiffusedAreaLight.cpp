@@ -1,6 +1,6 @@
 #include "DiffusedAreaLight.hpp"
 
-#include <glm/gtx/norm.hpp>
+#include <glm/gtc/constants.hpp>
 
 namespace Silmaril {
 
@@ -14,52 +14,29 @@ namespace Silmaril {
         f32 pdf = 0.0f;
         Interaction pShape = m_Shape->Sample(ref, u, pdf);
 
-        if (pdf == 0.0f || glm::length(pShape.p - ref.p) == 0.0f) return std::nullopt;
+        if (pdf == 0.0f || glm::isinf(pdf) || glm::length(pShape.p - ref.p) == 0.0f) return std::nullopt;
 
         LightSample ls;
         ls.wi = pShape.p - ref.p;
         ls.distance = glm::length(ls.wi);
         ls.wi = glm::normalize(ls.wi);
+        ls.pdf = pdf;
+        ls.li = L(pShape, -ls.wi);
 
-        f32 cosTheta = glm::abs(glm::dot(pShape.n, -ls.wi));
-        if (cosTheta == 0.0f) return std::nullopt;
-
-        ls.pdf = pdf * (ls.distance * ls.distance) / cosTheta;
-
-        if (glm::dot(pShape.n, -ls.wi) > 0.0f) {
-            ls.li = m_LEmit;
-        } else {
-            ls.li = glm::vec3(0.0f);
-        }
+        // Back faces emit nothing, no shadow ray is worth tracing toward them
+        if (ls.li == glm::vec3(0.0f)) return std::nullopt;
 
         return ls;
     }
 
     f32 DiffuseAreaLight::PdfLi(const Interaction& ref, const glm::vec3& wi) const
     {
-        Ray ray = ref.SpawnRay(wi);
-        f32 tHit;
-
-        if (!m_Shape->Intersect(ray, tHit, std::numeric_limits<f32>::max())) {
-            return 0.0f;
-        }
-
-        SurfaceInteraction intersection;
-        m_Shape->FillSurfaceInteraction(ray, tHit, intersection);
-
-        return PdfLi(ref, intersection);
+        return m_Shape->Pdf(ref, wi);
     }
 
     f32 DiffuseAreaLight::PdfLi(const Interaction& ref, const Interaction& lightHit) const
     {
-        f32 dist2 = glm::distance2(ref.p, lightHit.p);
-        glm::vec3 wi = glm::normalize(lightHit.p - ref.p);
-        f32 cosTheta = glm::abs(glm::dot(lightHit.n, -wi));
-        f32 area = m_Shape->Area();
-
-        if (cosTheta < 1e-4 || area <= 0.0f) return 0.0f;
-
-        return dist2 / (area * cosTheta);
+        return m_Shape->Pdf(ref, lightHit);
     }
 
     glm::vec3 DiffuseAreaLight::L(const Interaction& interaction, const glm::vec3& w) const
@@ -71,4 +48,26 @@ namespace Silmaril {
         return glm::vec3(0.0f);
     }
 
+    glm::vec3 DiffuseAreaLight::Phi() const
+    {
+        // Lambertian emission from the outward side, integrated over the hemisphere and the area
+        return glm::pi<f32>() * m_Shape->Area() * m_LEmit;
+    }
+
+    std::optional<LightBounds> DiffuseAreaLight::Bounds() const
+    {
+        glm::vec3 phi = Phi();
+        DirectionCone normals = m_Shape->NormalBounds();
+
+        LightBounds bounds;
+        bounds.bounds = m_Shape->GetBound();
+        bounds.w = normals.w;
+        bounds.cosThetaO = normals.cosTheta;
+        bounds.cosThetaE = 0.0f;
+        bounds.phi = (phi.r + phi.g + phi.b) / 3.0f;
+        bounds.twoSided = false;
+
+        return bounds;
+    }
+
 }
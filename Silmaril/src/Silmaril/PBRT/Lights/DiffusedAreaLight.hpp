@@ -18,6 +18,9 @@ namespace Silmaril {
 
         virtual glm::vec3 L(const Interaction& interaction, const glm::vec3& w) const override;
 
+        virtual glm::vec3 Phi() const override;
+        virtual std::optional<LightBounds> Bounds() const override;
+
     private:
         std::shared_ptr<Shape> m_Shape;
         glm::vec3 m_LEmit;
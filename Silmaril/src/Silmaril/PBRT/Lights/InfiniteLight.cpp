@@ -0,0 +1,127 @@
+#include "InfiniteLight.hpp"
+
+#include <stb_image.h>
+#include <glm/gtc/constants.hpp>
+
+#include "Silmaril/Core/Logger.hpp"
+
+#include <PathConfig.inl>
+
+namespace Silmaril {
+
+    namespace {
+
+        std::filesystem::path s_ResPath(PathConfig::ResDir);
+
+        glm::vec2 DirectionToUV(const glm::vec3& w)
+        {
+            f32 theta = glm::acos(std::clamp(w.y, -1.0f, 1.0f));
+            f32 phi = std::atan2(w.z, w.x);
+            if (phi < 0.0f) phi += 2.0f * glm::pi<f32>();
+
+            return glm::vec2(phi / (2.0f * glm::pi<f32>()), theta / glm::pi<f32>());
+        }
+
+    }
+
+    InfiniteLight::InfiniteLight(const std::string& filename, f32 scale)
+        : Light(LightFlags::Infinite)
+    {
+        std::string path = (s_ResPath / filename).string();
+
+        i32 channels = 0;
+        f32* data = stbi_loadf(path.c_str(), &m_Width, &m_Height, &channels, 3);
+        if (data) {
+            m_Radiance.resize(static_cast<usize>(m_Width) * m_Height);
+            for (usize i = 0; i < m_Radiance.size(); ++i) {
+                m_Radiance[i] = glm::vec3(data[i * 3 + 0], data[i * 3 + 1], data[i * 3 + 2]) * scale;
+            }
+
+            stbi_image_free(data);
+            LOG_INFO("Loaded environment: {} ({}, {})", filename, m_Width, m_Height);
+        } else {
+            LOG_ERROR("Failed to load environment: {}", filename);
+
+            m_Width = 1;
+            m_Height = 1;
+            m_Radiance = { glm::vec3(scale) };
+        }
+
+        // Rows near the poles cover less of the sphere, the sin theta keeps samples from piling up there
+        std::vector<f32> importance(m_Radiance.size());
+        for (i32 y = 0; y < m_Height; ++y) {
+            f32 sinTheta = glm::sin(glm::pi<f32>() * (y + 0.5f) / m_Height);
+
+            for (i32 x = 0; x < m_Width; ++x) {
+                const glm::vec3& L = m_Radiance[x + y * m_Width];
+
+                importance[x + y * m_Width] = glm::dot(L, glm::vec3(0.2126f, 0.7152f, 0.0722f)) * sinTheta;
+                m_Integral += L * sinTheta;
+            }
+        }
+
+        m_Integral *= 2.0f * glm::pi<f32>() * glm::pi<f32>() / (static_cast<f32>(m_Width) * m_Height);
+
+        m_Distribution = PiecewiseConstant2D(importance, m_Width, m_Height);
+    }
+
+    void InfiniteLight::Preprocess(const AABB& sceneBound)
+    {
+        if (sceneBound.x.min > sceneBound.x.max) return;
+
+        glm::vec3 extent(sceneBound.x.Size(), sceneBound.y.Size(), sceneBound.z.Size());
+        m_SceneRadius = std::max(glm::length(extent) * 0.5f, 1.0f);
+    }
+
+    std::optional<LightSample> InfiniteLight::SampleLi(const Interaction& ref, const glm::vec2& u) const
+    {
+        f32 mapPdf = 0.0f;
+        glm::vec2 uv = m_Distribution.Sample(u, mapPdf);
+        if (mapPdf == 0.0f) return std::nullopt;
+
+        f32 theta = uv.y * glm::pi<f32>();
+        f32 phi = uv.x * 2.0f * glm::pi<f32>();
+        f32 sinTheta = glm::sin(theta);
+        if (sinTheta == 0.0f) return std::nullopt;
+
+        LightSample ls;
+        ls.wi = glm::vec3(sinTheta * glm::cos(phi), glm::cos(theta), sinTheta * glm::sin(phi));
+        // From (u, v) to solid angle: dω = sinθ dθ dφ = 2π² sinθ du dv
+        ls.pdf = mapPdf / (2.0f * glm::pi<f32>() * glm::pi<f32>() * sinTheta);
+        // Past everything in the scene from anywhere inside it
+        ls.distance = 2.0f * m_SceneRadius;
+        ls.li = Lookup(uv);
+
+        return ls;
+    }
+
+    f32 InfiniteLight::PdfLi(const Interaction& ref, const glm::vec3& wi) const
+    {
+        glm::vec3 w = glm::normalize(wi);
+        f32 sinTheta = glm::sqrt(std::max(1.0f - w.y * w.y, 0.0f));
+        if (sinTheta == 0.0f) return 0.0f;
+
+        return m_Distribution.PDF(DirectionToUV(w)) / (2.0f * glm::pi<f32>() * glm::pi<f32>() * sinTheta);
+    }
+
+    glm::vec3 InfiniteLight::Le(const Ray& ray) const
+    {
+        return Lookup(DirectionToUV(glm::normalize(ray.direction)));
+    }
+
+    glm::vec3 InfiniteLight::Phi() const
+    {
+        // Through a disk as wide as the scene from every direction
+        return glm::pi<f32>() * m_SceneRadius * m_SceneRadius * m_Integral;
+    }
+
+    glm::vec3 InfiniteLight::Lookup(const glm::vec2& uv) const
+    {
+        // Nearest texel, the same steps the distribution samples, so Le / pdf stays flat across a bright texel's edge
+        i32 x = std::clamp(static_cast<i32>(uv.x * m_Width), 0, m_Width - 1);
+        i32 y = std::clamp(static_cast<i32>(uv.y * m_Height), 0, m_Height - 1);
+
+        return m_Radiance[x + y * m_Width];
+    }
+
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Light.hpp"
+#include "Silmaril/DSA/PiecewiseConstant.hpp"
+
+namespace Silmaril {
+
+    // Environment surrounding the scene from an HDR lat-long map: the top row looks along +y, u turns around y.
+    // Directions are importance sampled by luminance over the sphere.
+    class InfiniteLight final : public Light
+    {
+    public:
+        InfiniteLight(const std::string& filename, f32 scale = 1.0f);
+        virtual ~InfiniteLight() = default;
+
+        virtual void Preprocess(const AABB& sceneBound) override;
+
+        virtual std::optional<LightSample> SampleLi(const Interaction& ref, const glm::vec2& u) const override;
+        virtual f32 PdfLi(const Interaction& ref, const glm::vec3& wi) const override;
+
+        virtual glm::vec3 Le(const Ray& ray) const override;
+
+        virtual glm::vec3 Phi() const override;
+
+    private:
+        glm::vec3 Lookup(const glm::vec2& uv) const;
+
+    private:
+        std::vector<glm::vec3> m_Radiance;
+        i32 m_Width { 0 };
+        i32 m_Height { 0 };
+
+        PiecewiseConstant2D m_Distribution;
+        // Radiance integrated over the sphere of directions
+        glm::vec3 m_Integral { 0.0f };
+
+        f32 m_SceneRadius { 1.0f };
+    };
+
+}
@@ -3,6 +3,9 @@
 #include <glm/glm.hpp>
 
 #include "Silmaril/PBRT/Containers/Interaction.hpp"
+#include "Silmaril/PBRT/Containers/AABB.hpp"
+#include "Silmaril/PBRT/Containers/Ray.hpp"
+#include "LightBounds.hpp"
 
 namespace Silmaril {
 
@@ -40,6 +43,11 @@ namespace Silmaril {
 
         virtual ~Light() = default;
 
+        // Called once the scene is built, lights at infinity size themselves to its bound
+        virtual void Preprocess(const AABB& sceneBound)
+        {
+        }
+
         virtual std::optional<LightSample> SampleLi(const Interaction& ref, const glm::vec2& u) const = 0;
 
         virtual f32 PdfLi(const Interaction& ref, const glm::vec3& wi) const
@@ -57,6 +65,24 @@ namespace Silmaril {
             return glm::vec3(0.0f);
         }
 
+        // Radiance along a ray that leaves the scene, only lights at infinity have any
+        virtual glm::vec3 Le(const Ray& ray) const
+        {
+            return glm::vec3(0.0f);
+        }
+
+        // Total power the light emits into the scene
+        virtual glm::vec3 Phi() const
+        {
+            return glm::vec3(0.0f);
+        }
+
+        // Spatial and directional bounds for the light BVH, none for lights at infinity
+        virtual std::optional<LightBounds> Bounds() const
+        {
+            return std::nullopt;
+        }
+
         virtual bool IsDelta() const { return IsDeltaLight(m_Flags); }
 
     private:
@@ -0,0 +1,203 @@
+#include "LightBVH.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+namespace Silmaril {
+
+    namespace {
+
+        constexpr u32 s_Bins = 12;
+
+        // Past this depth the build splits at the median, which keeps every trail within 64 bits
+        constexpr u32 s_MaxCostDepth = 32;
+
+        // Orientation-weighted surface area cost of a split candidate, as in the pbrt-v4 light BVH
+        f32 EvaluateCost(const LightBounds& b, const AABB& bounds, u32 axis)
+        {
+            f32 thetaO = std::acos(std::clamp(b.cosThetaO, -1.0f, 1.0f));
+            f32 thetaE = std::acos(std::clamp(b.cosThetaE, -1.0f, 1.0f));
+            f32 thetaW = std::min(thetaO + thetaE, glm::pi<f32>());
+            f32 sinThetaO = std::sqrt(std::max(1.0f - b.cosThetaO * b.cosThetaO, 0.0f));
+
+            f32 mOmega = 2.0f * glm::pi<f32>() * (1.0f - b.cosThetaO) +
+                glm::pi<f32>() / 2.0f * (2.0f * thetaW * sinThetaO - std::cos(thetaO - 2.0f * thetaW) - 2.0f * thetaO * sinThetaO + b.cosThetaO);
+
+            // Penalizes thin slabs, so the split favors the long axes of the node
+            glm::vec3 extent(bounds.x.Size(), bounds.y.Size(), bounds.z.Size());
+            f32 maxExtent = std::max({ extent.x, extent.y, extent.z });
+            f32 kr = extent[axis] > 0.0f ? maxExtent / extent[axis] : 1.0f;
+
+            return b.phi * mOmega * kr * b.bounds.SurfaceArea();
+        }
+
+    }
+
+    LightBVH::LightBVH(const std::vector<std::pair<const Light*, LightBounds>>& lights)
+    {
+        std::vector<std::pair<const Light*, LightBounds>> build;
+        build.reserve(lights.size());
+
+        for (const auto& light : lights) {
+            if (light.second.phi > 0.0f) build.push_back(light);
+        }
+
+        if (build.empty()) return;
+
+        m_Nodes.reserve(2 * build.size() - 1);
+        m_Lights.reserve(build.size());
+
+        Build(build, 0, static_cast<u32>(build.size()), 0, 0);
+    }
+
+    u32 LightBVH::Build(std::vector<std::pair<const Light*, LightBounds>>& lights, u32 start, u32 end, u64 trail, u32 depth)
+    {
+        m_Depth = std::max(m_Depth, depth);
+
+        u32 nodeIndex = static_cast<u32>(m_Nodes.size());
+        m_Nodes.emplace_back();
+
+        if (end - start == 1) {
+            const auto& [light, bounds] = lights[start];
+
+            m_Nodes[nodeIndex] = { bounds, static_cast<u32>(m_Lights.size()), 1 };
+            m_Lights.push_back(light);
+            m_Trails[light] = trail;
+
+            return nodeIndex;
+        }
+
+        AABB bounds;
+        AABB centroidBounds;
+        for (u32 i = start; i < end; ++i) {
+            const AABB& b = lights[i].second.bounds;
+            glm::vec3 c = b.Centroid();
+
+            bounds = AABB(bounds, b);
+            centroidBounds = AABB(centroidBounds, AABB(c, c));
+        }
+
+        f32 minCost = std::numeric_limits<f32>::infinity();
+        u32 minAxis = 0;
+        u32 minBucket = 0;
+
+        if (depth < s_MaxCostDepth) {
+            for (u32 axis = 0; axis < 3; ++axis) {
+                const Bounds& axisBounds = centroidBounds.AxisBounds(axis);
+                if (axisBounds.max == axisBounds.min) continue;
+
+                std::array<LightBounds, s_Bins> bins;
+                for (u32 i = start; i < end; ++i) {
+                    f32 c = lights[i].second.bounds.Centroid()[axis];
+                    u32 b = std::min(static_cast<u32>(s_Bins * (c - axisBounds.min) / axisBounds.Size()), s_Bins - 1);
+                    bins[b] = LightBounds::Union(bins[b], lights[i].second);
+                }
+
+                for (u32 split = 0; split < s_Bins - 1; ++split) {
+                    LightBounds below;
+                    LightBounds above;
+                    for (u32 b = 0; b <= split; ++b) below = LightBounds::Union(below, bins[b]);
+                    for (u32 b = split + 1; b < s_Bins; ++b) above = LightBounds::Union(above, bins[b]);
+
+                    f32 cost = EvaluateCost(below, bounds, axis) + EvaluateCost(above, bounds, axis);
+                    if (cost > 0.0f && cost < minCost) {
+                        minCost = cost;
+                        minAxis = axis;
+                        minBucket = split;
+                    }
+                }
+            }
+        }
+
+        u32 mid;
+        if (minCost == std::numeric_limits<f32>::infinity()) {
+            mid = (start + end) / 2;
+        } else {
+            const Bounds& axisBounds = centroidBounds.AxisBounds(minAxis);
+            auto it = std::partition(lights.begin() + start, lights.begin() + end, [&](const auto& light) {
+                f32 c = light.second.bounds.Centroid()[minAxis];
+                u32 b = std::min(static_cast<u32>(s_Bins * (c - axisBounds.min) / axisBounds.Size()), s_Bins - 1);
+                return b <= minBucket;
+            });
+
+            mid = static_cast<u32>(it - lights.begin());
+            if (mid == start || mid == end) mid = (start + end) / 2;
+        }
+
+        Build(lights, start, mid, trail, depth + 1);
+        u32 second = Build(lights, mid, end, trail | (u64 { 1 } << depth), depth + 1);
+
+        m_Nodes[nodeIndex].bounds = LightBounds::Union(m_Nodes[nodeIndex + 1].bounds, m_Nodes[second].bounds);
+        m_Nodes[nodeIndex].index = second;
+        m_Nodes[nodeIndex].leaf = 0;
+
+        return nodeIndex;
+    }
+
+    const Light* LightBVH::Sample(const glm::vec3& p, const glm::vec3& n, f32 u, f32& pmf) const
+    {
+        pmf = 0.0f;
+        if (m_Nodes.empty()) return nullptr;
+
+        u32 nodeIndex = 0;
+        f32 nodePmf = 1.0f;
+
+        while (!m_Nodes[nodeIndex].leaf) {
+            const Node& node = m_Nodes[nodeIndex];
+
+            f32 i0 = m_Nodes[nodeIndex + 1].bounds.Importance(p, n);
+            f32 i1 = m_Nodes[node.index].bounds.Importance(p, n);
+            if (i0 == 0.0f && i1 == 0.0f) return nullptr;
+
+            // Picks a child and rescales u to [0, 1) for the rest of the walk
+            f32 p0 = i0 / (i0 + i1);
+            if (u < p0) {
+                nodeIndex = nodeIndex + 1;
+                u = std::min(u / p0, 0x1.fffffep-1f);
+                nodePmf *= p0;
+            } else {
+                nodeIndex = node.index;
+                u = std::min((u - p0) / (1.0f - p0), 0x1.fffffep-1f);
+                nodePmf *= 1.0f - p0;
+            }
+        }
+
+        // A single light is only worth a shadow ray when it can reach p
+        if (nodeIndex == 0 && m_Nodes[0].bounds.Importance(p, n) == 0.0f) return nullptr;
+
+        pmf = nodePmf;
+        return m_Lights[m_Nodes[nodeIndex].index];
+    }
+
+    f32 LightBVH::PMF(const glm::vec3& p, const glm::vec3& n, const Light* light) const
+    {
+        auto it = m_Trails.find(light);
+        if (it == m_Trails.end()) return 0.0f;
+
+        u64 trail = it->second;
+        u32 nodeIndex = 0;
+        f32 pmf = 1.0f;
+
+        while (!m_Nodes[nodeIndex].leaf) {
+            const Node& node = m_Nodes[nodeIndex];
+
+            f32 i0 = m_Nodes[nodeIndex + 1].bounds.Importance(p, n);
+            f32 i1 = m_Nodes[node.index].bounds.Importance(p, n);
+            if (i0 == 0.0f && i1 == 0.0f) return 0.0f;
+
+            if (trail & 1) {
+                nodeIndex = node.index;
+                pmf *= i1 / (i0 + i1);
+            } else {
+                nodeIndex = nodeIndex + 1;
+                pmf *= i0 / (i0 + i1);
+            }
+
+            trail >>= 1;
+        }
+
+        if (nodeIndex == 0 && m_Nodes[0].bounds.Importance(p, n) == 0.0f) return 0.0f;
+
+        return pmf;
+    }
+
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include "Light.hpp"
+#include "LightBounds.hpp"
+
+namespace Silmaril {
+
+    // Binary tree over the bounded lights: next event estimation walks it from the root, choosing each child
+    // in proportion to its importance at the shading point, so picking a light costs O(log n) in the light count
+    class LightBVH
+    {
+    public:
+        LightBVH() = default;
+        LightBVH(const std::vector<std::pair<const Light*, LightBounds>>& lights);
+
+        inline bool IsEmpty() const { return m_Nodes.empty(); }
+
+        // nullptr when no light can reach p
+        const Light* Sample(const glm::vec3& p, const glm::vec3& n, f32 u, f32& pmf) const;
+
+        // Probability Sample picks the light at p with normal n, 0 for lights outside the tree
+        f32 PMF(const glm::vec3& p, const glm::vec3& n, const Light* light) const;
+
+        inline u32 GetNodeCount() const { return static_cast<u32>(m_Nodes.size()); }
+        inline u32 GetDepth() const { return m_Depth; }
+
+    private:
+        struct Node
+        {
+            LightBounds bounds;
+            // Interior nodes: the second child, the first follows the node directly. Leaves: the light
+            u32 index;
+            u8 leaf;
+        };
+
+        u32 Build(std::vector<std::pair<const Light*, LightBounds>>& lights, u32 start, u32 end, u64 trail, u32 depth);
+
+    private:
+        std::vector<Node> m_Nodes;
+        std::vector<const Light*> m_Lights;
+
+        // Path from the root to each light, bit i set when the walk takes the second child at depth i
+        std::unordered_map<const Light*, u64> m_Trails;
+        u32 m_Depth { 0 };
+    };
+
+}
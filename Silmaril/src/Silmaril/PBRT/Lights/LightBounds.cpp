@@ -0,0 +1,87 @@
+#include "LightBounds.hpp"
+
+namespace Silmaril {
+
+    namespace {
+
+        f32 SafeSqrt(f32 x)
+        {
+            return std::sqrt(std::max(x, 0.0f));
+        }
+
+        // cos(max(0, a - b)) from the sines and cosines of both angles
+        f32 CosSubClamped(f32 sinA, f32 cosA, f32 sinB, f32 cosB)
+        {
+            if (cosA > cosB) return 1.0f;
+            return cosA * cosB + sinA * sinB;
+        }
+
+        f32 SinSubClamped(f32 sinA, f32 cosA, f32 sinB, f32 cosB)
+        {
+            if (cosA > cosB) return 0.0f;
+            return sinA * cosB - cosA * sinB;
+        }
+
+    }
+
+    f32 LightBounds::Importance(const glm::vec3& p, const glm::vec3& n) const
+    {
+        glm::vec3 pMin(bounds.x.min, bounds.y.min, bounds.z.min);
+        glm::vec3 pMax(bounds.x.max, bounds.y.max, bounds.z.max);
+        glm::vec3 pc = (pMin + pMax) * 0.5f;
+        f32 radius = glm::length(pMax - pMin) * 0.5f;
+
+        // Inside the bounds the distance is clamped, so nearby lights do not blow up
+        f32 d2 = glm::dot(p - pc, p - pc);
+        d2 = std::max(d2, radius);
+
+        glm::vec3 wi = d2 > 0.0f ? (p - pc) / std::sqrt(glm::dot(p - pc, p - pc)) : glm::vec3(0.0f);
+        f32 cosThetaW = glm::dot(w, wi);
+        if (twoSided) cosThetaW = std::abs(cosThetaW);
+        f32 sinThetaW = SafeSqrt(1.0f - cosThetaW * cosThetaW);
+
+        // Angle the bounds subtend from p, through their bounding sphere
+        f32 cosThetaB = -1.0f;
+        if (glm::dot(p - pc, p - pc) > radius * radius) {
+            f32 sin2ThetaMax = radius * radius / glm::dot(p - pc, p - pc);
+            cosThetaB = SafeSqrt(1.0f - sin2ThetaMax);
+        }
+        f32 sinThetaB = SafeSqrt(1.0f - cosThetaB * cosThetaB);
+
+        // Smallest angle between an emitting normal and the direction toward p
+        f32 sinThetaO = SafeSqrt(1.0f - cosThetaO * cosThetaO);
+        f32 cosThetaX = CosSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+        f32 sinThetaX = SinSubClamped(sinThetaW, cosThetaW, sinThetaO, cosThetaO);
+        f32 cosThetaP = CosSubClamped(sinThetaX, cosThetaX, sinThetaB, cosThetaB);
+        if (cosThetaP <= cosThetaE) return 0.0f;
+
+        f32 importance = phi * cosThetaP / d2;
+
+        if (n != glm::vec3(0.0f)) {
+            f32 cosThetaI = std::abs(glm::dot(wi, n));
+            f32 sinThetaI = SafeSqrt(1.0f - cosThetaI * cosThetaI);
+            importance *= CosSubClamped(sinThetaI, cosThetaI, sinThetaB, cosThetaB);
+        }
+
+        return std::max(importance, 0.0f);
+    }
+
+    LightBounds LightBounds::Union(const LightBounds& a, const LightBounds& b)
+    {
+        if (a.phi == 0.0f) return b;
+        if (b.phi == 0.0f) return a;
+
+        DirectionCone cone = DirectionCone::Union(DirectionCone(a.w, a.cosThetaO), DirectionCone(b.w, b.cosThetaO));
+
+        LightBounds result;
+        result.bounds = AABB(a.bounds, b.bounds);
+        result.w = cone.w;
+        result.cosThetaO = cone.cosTheta;
+        result.cosThetaE = std::min(a.cosThetaE, b.cosThetaE);
+        result.phi = a.phi + b.phi;
+        result.twoSided = a.twoSided || b.twoSided;
+
+        return result;
+    }
+
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include "Silmaril/PBRT/Containers/AABB.hpp"
+#include "Silmaril/PBRT/Containers/DirectionCone.hpp"
+
+namespace Silmaril {
+
+    // Where a light (or a group of lights) sits, which way it faces and how much it emits, for the light BVH
+    struct LightBounds
+    {
+        AABB bounds;
+        // Axis of the surface normals and cos of their spread around it
+        glm::vec3 w { 0.0f, 0.0f, 1.0f };
+        f32 cosThetaO { 1.0f };
+        // Cos of how far past the normals emission reaches, 0 for diffuse emitters
+        f32 cosThetaE { 0.0f };
+        f32 phi { 0.0f };
+        bool twoSided { false };
+
+        // Conservative estimate of the light's contribution at p, n of zero skips the cosine at the receiver
+        f32 Importance(const glm::vec3& p, const glm::vec3& n) const;
+
+        static LightBounds Union(const LightBounds& a, const LightBounds& b);
+    };
+
+}
@@ -0,0 +1,162 @@
+#include "MeshLight.hpp"
+
+#include <glm/gtc/constants.hpp>
+
+namespace Silmaril {
+
+    MeshLight::MeshLight(const std::shared_ptr<TriangleMesh>& mesh, const glm::mat4& objectToWorld)
+        :   Light(LightFlags::Area),
+            m_Mesh(mesh),
+            m_ObjectToWorld(objectToWorld),
+            m_NormalToWorld(glm::transpose(glm::inverse(glm::mat3(objectToWorld))))
+    {
+        std::vector<f32> importance;
+
+        for (u32 triangle = 0; triangle < m_Mesh->GetTriangleCount(); ++triangle) {
+            const glm::vec3& Le = m_Mesh->GetEmission(triangle);
+            if (Le == glm::vec3(0.0f)) continue;
+
+            TriangleVertices vertices = GetWorldVertices(triangle);
+            f32 area = Triangle::Area(vertices.p);
+            if (area == 0.0f) continue;
+
+            m_Triangles.push_back(triangle);
+            m_Areas.push_back(area);
+            importance.push_back(area * glm::dot(Le, glm::vec3(0.2126f, 0.7152f, 0.0722f)));
+
+            m_Phi += glm::pi<f32>() * area * Le;
+
+            AABB bound = Triangle::GetBound(vertices.p);
+            m_Bound = (m_Triangles.size() == 1) ? bound : AABB(m_Bound, bound);
+            m_Normals = DirectionCone::Union(m_Normals, DirectionCone(EmittingNormal(vertices)));
+        }
+
+        m_Distribution = PiecewiseConstant1D(importance);
+    }
+
+    std::optional<LightSample> MeshLight::SampleLi(const Interaction& ref, const glm::vec2& u) const
+    {
+        if (m_Triangles.empty()) return std::nullopt;
+
+        f32 density = 0.0f;
+        u32 index = 0;
+        f32 x = m_Distribution.Sample(u[0], density, index);
+        if (density == 0.0f) return std::nullopt;
+
+        u32 n = m_Distribution.GetSize();
+        f32 pmf = density / n;
+
+        // Where u[0] landed inside the triangle's step is uniform again, it places the point on the triangle
+        f32 uTriangle = std::clamp(x * n - index, 0.0f, 0x1.fffffep-1f);
+
+        u32 triangle = m_Triangles[index];
+        TriangleVertices vertices = GetWorldVertices(triangle);
+
+        f32 areaPdf = 0.0f;
+        Interaction pLight = Triangle::Sample(vertices, glm::vec2(uTriangle, u[1]), areaPdf);
+
+        glm::vec3 d = pLight.p - ref.p;
+        f32 dist2 = glm::dot(d, d);
+        if (dist2 == 0.0f) return std::nullopt;
+
+        LightSample ls;
+        ls.distance = glm::sqrt(dist2);
+        ls.wi = d / ls.distance;
+
+        // Back faces emit nothing, and grazing ones would blow up the density
+        f32 cosTheta = glm::dot(EmittingNormal(vertices), -ls.wi);
+        if (cosTheta < 1e-4f) return std::nullopt;
+
+        ls.pdf = pmf * areaPdf * dist2 / cosTheta;
+        ls.li = m_Mesh->GetEmission(triangle);
+
+        return ls;
+    }
+
+    f32 MeshLight::PdfLi(const Interaction& ref, const Interaction& lightHit) const
+    {
+        if (!lightHit.IsSurfaceInteraction()) return 0.0f;
+
+        u32 index = FindEmitter(static_cast<const SurfaceInteraction&>(lightHit).triangle);
+        if (index == GetTriangleCount()) return 0.0f;
+
+        glm::vec3 d = lightHit.p - ref.p;
+        f32 dist2 = glm::dot(d, d);
+        if (dist2 == 0.0f) return 0.0f;
+
+        f32 cosTheta = glm::abs(glm::dot(EmittingNormal(GetWorldVertices(m_Triangles[index])), d)) / glm::sqrt(dist2);
+        if (cosTheta < 1e-4f) return 0.0f;
+
+        f32 pmf = m_Distribution.PDF(index) / m_Distribution.GetSize();
+
+        return pmf / m_Areas[index] * dist2 / cosTheta;
+    }
+
+    glm::vec3 MeshLight::L(const Interaction& interaction, const glm::vec3& w) const
+    {
+        if (!interaction.IsSurfaceInteraction()) return glm::vec3(0.0f);
+
+        u32 triangle = static_cast<const SurfaceInteraction&>(interaction).triangle;
+        if (FindEmitter(triangle) == GetTriangleCount()) return glm::vec3(0.0f);
+
+        if (glm::dot(EmittingNormal(GetWorldVertices(triangle)), w) > 0.0f) {
+            return m_Mesh->GetEmission(triangle);
+        }
+
+        return glm::vec3(0.0f);
+    }
+
+    glm::vec3 MeshLight::Phi() const
+    {
+        return m_Phi;
+    }
+
+    std::optional<LightBounds> MeshLight::Bounds() const
+    {
+        if (m_Triangles.empty()) return std::nullopt;
+
+        LightBounds bounds;
+        bounds.bounds = m_Bound;
+        bounds.w = m_Normals.w;
+        bounds.cosThetaO = m_Normals.cosTheta;
+        bounds.cosThetaE = 0.0f;
+        bounds.phi = (m_Phi.r + m_Phi.g + m_Phi.b) / 3.0f;
+        bounds.twoSided = false;
+
+        return bounds;
+    }
+
+    u32 MeshLight::FindEmitter(u32 triangle) const
+    {
+        auto it = std::lower_bound(m_Triangles.begin(), m_Triangles.end(), triangle);
+        if (it == m_Triangles.end() || *it != triangle) return GetTriangleCount();
+
+        return static_cast<u32>(it - m_Triangles.begin());
+    }
+
+    TriangleVertices MeshLight::GetWorldVertices(u32 triangle) const
+    {
+        TriangleVertices vertices = m_Mesh->GetVertices(triangle);
+
+        for (u32 i = 0; i < 3; ++i) {
+            vertices.p[i] = glm::vec3(m_ObjectToWorld * glm::vec4(vertices.p[i], 1.0f));
+            if (vertices.hasNormals) {
+                vertices.n[i] = glm::normalize(m_NormalToWorld * vertices.n[i]);
+            }
+        }
+
+        return vertices;
+    }
+
+    glm::vec3 MeshLight::EmittingNormal(const TriangleVertices& vertices) const
+    {
+        glm::vec3 ng = glm::normalize(glm::cross(vertices.p[1] - vertices.p[0], vertices.p[2] - vertices.p[0]));
+
+        if (vertices.hasNormals && glm::dot(ng, vertices.n[0] + vertices.n[1] + vertices.n[2]) < 0.0f) {
+            ng = -ng;
+        }
+
+        return ng;
+    }
+
+}
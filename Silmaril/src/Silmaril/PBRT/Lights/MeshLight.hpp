@@ -0,0 +1,54 @@
+#pragma once
+
+#include "Light.hpp"
+#include "Silmaril/PBRT/Geometry/TriangleMesh.hpp"
+#include "Silmaril/DSA/PiecewiseConstant.hpp"
+
+namespace Silmaril {
+
+    // Every emissive triangle of one placement of a mesh as a single diffuse area light. Triangles are picked in
+    // proportion to area times luminance, then a point is picked uniformly on the triangle. Emission leaves the side
+    // the vertex normals face, or the winding's side without them.
+    class MeshLight final : public Light
+    {
+    public:
+        // Built for the transform the mesh is placed with, moving the instance afterwards leaves the light behind
+        MeshLight(const std::shared_ptr<TriangleMesh>& mesh, const glm::mat4& objectToWorld);
+        virtual ~MeshLight() = default;
+
+        inline u32 GetTriangleCount() const { return static_cast<u32>(m_Triangles.size()); }
+        inline bool IsEmitter(u32 triangle) const { return std::binary_search(m_Triangles.begin(), m_Triangles.end(), triangle); }
+
+        virtual std::optional<LightSample> SampleLi(const Interaction& ref, const glm::vec2& u) const override;
+
+        // Hits must be the SurfaceInteraction of a triangle of the mesh
+        virtual f32 PdfLi(const Interaction& ref, const Interaction& lightHit) const override;
+        virtual glm::vec3 L(const Interaction& interaction, const glm::vec3& w) const override;
+
+        virtual glm::vec3 Phi() const override;
+        virtual std::optional<LightBounds> Bounds() const override;
+
+    private:
+        // Position of an emitter in m_Triangles, or the count when the triangle does not emit
+        u32 FindEmitter(u32 triangle) const;
+
+        TriangleVertices GetWorldVertices(u32 triangle) const;
+        glm::vec3 EmittingNormal(const TriangleVertices& vertices) const;
+
+    private:
+        std::shared_ptr<TriangleMesh> m_Mesh;
+        glm::mat4 m_ObjectToWorld;
+        glm::mat3 m_NormalToWorld;
+
+        // Sorted mesh indices of the emitting triangles and their world space areas
+        std::vector<u32> m_Triangles;
+        std::vector<f32> m_Areas;
+
+        PiecewiseConstant1D m_Distribution;
+
+        glm::vec3 m_Phi { 0.0f };
+        AABB m_Bound;
+        DirectionCone m_Normals;
+    };
+
+}
@@ -7,6 +7,7 @@
 #include "Cameras/PerspectiveCamera.hpp"
 #include "Samplers/StratifiedSampler.hpp"
 #include "Integrators/RandomWalkIntegrator.hpp"
+#include "Integrators/WavefrontIntegrator.hpp"
 
 #include "Loaders/ModelLoader.hpp"
 #include "Geometry/GeometricPrimitive.hpp"
@@ -14,6 +15,8 @@
 #include "Geometry/BVH.hpp"
 #include "Materials/MatteMaterial.hpp"
 #include "Lights/DiffusedAreaLight.hpp"
+#include "Lights/InfiniteLight.hpp"
+#include "Lights/MeshLight.hpp"
 
 namespace Silmaril {
 
@@ -34,18 +37,41 @@ namespace Silmaril {
 
         m_Sampler = std::make_shared<StratifiedSampler>(m_Config.samples);
 
-        m_Integrator = std::make_unique<RandomWalkIntegrator>(RandomWalkIntegrator::Config{
-            m_Camera,
-            m_Sampler,
-            m_Config.depth,
-            m_Config.tile,
-            m_Config.output
-        });
+        if (m_Config.integrator == IntegratorType::Wavefront) {
+            m_Integrator = std::make_unique<WavefrontIntegrator>(WavefrontIntegrator::Config{
+                m_Camera,
+                m_Sampler,
+                m_Config.depth,
+                m_Config.tile,
+                m_Config.output,
+                m_Config.adaptiveThreshold,
+                m_Config.adaptiveMinSamples,
+                m_Config.timeBudget
+            });
+        } else {
+            m_Integrator = std::make_unique<RandomWalkIntegrator>(RandomWalkIntegrator::Config{
+                m_Camera,
+                m_Sampler,
+                m_Config.depth,
+                m_Config.tile,
+                m_Config.output,
+                m_Config.adaptiveThreshold,
+                m_Config.adaptiveMinSamples,
+                m_Config.timeBudget
+            });
+        }
 
         LOG_INFO("Integrator Settings");
+        LOG_INFO(" - Type:       {}", m_Config.integrator == IntegratorType::Wavefront ? "Wavefront" : "RandomWalk");
         LOG_INFO(" - Resolution: {}x{}", m_Config.width, m_Config.height);
         LOG_INFO(" - samples:    {}", m_Config.samples);
         LOG_INFO(" - depth:      {}", m_Config.depth);
+        if (m_Config.adaptiveThreshold > 0.0f) {
+            LOG_INFO(" - adaptive:   {:.4f} after {} samples", m_Config.adaptiveThreshold, m_Config.adaptiveMinSamples);
+        }
+        if (m_Config.timeBudget > 0.0f) {
+            LOG_INFO(" - budget:     {:.2f} seconds", m_Config.timeBudget);
+        }
 
         LOG_INFO("Camera Settings:");
         LOG_INFO(" - Position:   {}", glm::to_string(m_Config.lookfrom));
@@ -65,8 +91,43 @@ namespace Silmaril {
 
         auto model = ModelLoader::LoadOBJ(m_Config.model);
         if (model) {
-            auto modelPrimitives = model->CreatePrimitives();
-            primitives.insert(primitives.end(), modelPrimitives.begin(), modelPrimitives.end());
+            auto modelMesh = m_Config.compressModel ? model->CreateTriangleMesh(m_Config.compression) : model->CreateTriangleMesh();
+            u32 modelTriangles = modelMesh->GetTriangleCount();
+
+            LOG_INFO("Building Model BVH...");
+            auto BLASStart = std::chrono::steady_clock::now();
+            m_ModelPrimitive = BVH::Create(std::vector<std::shared_ptr<TriangleMesh>> { modelMesh }, m_Config.bvh);
+            auto BLASEnd = std::chrono::steady_clock::now();
+
+            std::chrono::duration<f64> timeBLAS = BLASEnd - BLASStart;
+            LOG_INFO("Model BVH built in {:.4f} seconds", timeBLAS.count());
+
+            // The model BVH is shared by every instance, the top-level BVH only sees the instances
+            if (m_Config.instances.empty()) {
+                m_Instances.push_back(std::make_shared<TransformedPrimitive>(m_ModelPrimitive, glm::mat4(1.0f)));
+            } else {
+                for (const glm::mat4& transform : m_Config.instances) {
+                    m_Instances.push_back(std::make_shared<TransformedPrimitive>(m_ModelPrimitive, transform));
+                }
+            }
+
+            primitives.insert(primitives.end(), m_Instances.begin(), m_Instances.end());
+
+            LOG_INFO("Model Instances: {} of {} triangles", m_Instances.size(), modelTriangles);
+
+            // One light per instance covers every emissive triangle of the model
+            if (modelMesh->IsEmissive()) {
+                u32 emitters = 0;
+                for (const auto& instance : m_Instances) {
+                    auto meshLight = std::make_shared<MeshLight>(modelMesh, instance->GetTransform());
+                    emitters += meshLight->GetTriangleCount();
+
+                    instance->SetLight(meshLight);
+                    m_Lights.push_back(meshLight);
+                }
+
+                LOG_INFO("Model Lights: {} instances, {} emissive triangles in total", m_Instances.size(), emitters);
+            }
         } else {
             LOG_WARN("No model loaded, falling back to sphere");
 
@@ -99,18 +160,29 @@ namespace Silmaril {
         primitives.push_back(std::make_shared<GeometricPrimitive>(sphere2, lightMat, light2));
         primitives.push_back(std::make_shared<GeometricPrimitive>(sphere3, lightMat, light3));
 
+        if (!m_Config.environment.empty()) {
+            m_Lights.push_back(std::make_shared<InfiniteLight>(m_Config.environment, m_Config.environmentScale));
+        }
+
         LOG_INFO("Total Primitives: {}", primitives.size());
         LOG_INFO("Total Lights: {}", m_Lights.size());
 
-        LOG_INFO("Building Aggregate BVH...");
+        LOG_INFO("Building Top-Level BVH...");
         auto BVHStart = std::chrono::steady_clock::now();
-        m_AggregatePrimitive = BVH::Create(std::move(primitives));
+        m_AggregatePrimitive = BVH::Create(std::move(primitives), m_Config.bvh);
         auto BVHEnd = std::chrono::steady_clock::now();
 
         std::chrono::duration<f64> timeBVH = BVHEnd - BVHStart;
         LOG_INFO("BVH built in {:.4f} seconds", timeBVH.count());
 
-        m_Scene = std::make_unique<Scene>(m_AggregatePrimitive, m_Lights);
+        m_Scene = std::make_unique<Scene>(m_AggregatePrimitive, m_Lights, m_Config.lightSampling);
+
+        if (m_Config.lightSampling == Scene::LightSampling::BVH) {
+            const LightBVH& lightBVH = m_Scene->GetLightBVH();
+            LOG_INFO("Light Sampling: BVH ({} nodes, depth {})", lightBVH.GetNodeCount(), lightBVH.GetDepth());
+        } else {
+            LOG_INFO("Light Sampling: Power");
+        }
     }
 
     void PBRT::Render()
@@ -127,6 +199,22 @@ namespace Silmaril {
         }
     }
 
+    void PBRT::RefitScene()
+    {
+        if (auto bvh = std::dynamic_pointer_cast<BVH>(m_ModelPrimitive)) {
+            bvh->Refit();
+
+            // Instance bounds are cached from the model bounds
+            for (const auto& instance : m_Instances) {
+                instance->SetTransform(instance->GetTransform());
+            }
+        }
+
+        if (auto bvh = std::dynamic_pointer_cast<BVH>(m_AggregatePrimitive)) {
+            bvh->Refit();
+        }
+    }
+
     void PBRT::SetTileRenderCallback(Integrator::OnRenderCallback callback)
     {
         m_Integrator->SetRenderCallback(callback);
@@ -5,12 +5,23 @@
 #include "Samplers/Sampler.hpp"
 #include "Integrators/Integrator.hpp"
 #include "Scene/Scene.hpp"
+#include "Geometry/BVH.hpp"
+#include "Geometry/CompressedMesh.hpp"
+#include "Geometry/TransformedPrimitive.hpp"
 
 namespace Silmaril {
 
     class PBRT
     {
     public:
+        enum class IntegratorType : u8
+        {
+            // Depth-first, one path at a time per pixel
+            RandomWalk,
+            // Breadth-first over a pool of paths, see WavefrontIntegrator
+            Wavefront
+        };
+
         struct Config
         {
             u32 width;
@@ -20,6 +31,15 @@ namespace Silmaril {
             u32 tile;
 
             std::string model;
+            // Object to world transforms the model is instanced with, empty places it once as loaded
+            std::vector<glm::mat4> instances;
+            // Keep the model's vertex attributes quantized instead of as floats, see CompressedMesh
+            bool compressModel { false };
+            CompressedMesh::Config compression;
+
+            // HDR lat-long map under the resource folder lighting the scene from every direction, empty keeps the gradient sky
+            std::string environment;
+            f32 environmentScale { 1.0f };
 
             glm::vec3 lookfrom;
             glm::vec3 lookat;
@@ -27,6 +47,19 @@ namespace Silmaril {
             f32 fov;
 
             std::string output;
+
+            BVH::Config bvh;
+
+            IntegratorType integrator { IntegratorType::RandomWalk };
+            // The light BVH pays off past a handful of emitters, its upper nodes are too coarse for a few distant lights
+            Scene::LightSampling lightSampling { Scene::LightSampling::Power };
+
+            // Relative error a pixel stops sampling at, 0 disables adaptive sampling
+            f32 adaptiveThreshold { 0.0f };
+            u32 adaptiveMinSamples { 16 };
+
+            // Wall-clock seconds for the render with samples as the cap on passes, 0 renders every sample
+            f32 timeBudget { 0.0f };
         };
 
     public:
@@ -38,6 +71,9 @@ namespace Silmaril {
         void LoadScene();
         void Render();
 
+        // Refits the model BVH and then the top-level BVH after scene geometry or instances moved, without reloading the scene
+        void RefitScene();
+
         void SetTileRenderCallback(Integrator::OnRenderCallback callback);
         void RequestStop();
 
@@ -49,6 +85,8 @@ namespace Silmaril {
         std::shared_ptr<Sampler> m_Sampler;
         std::unique_ptr<Integrator> m_Integrator;
 
+        std::shared_ptr<Primitive> m_ModelPrimitive;
+        std::vector<std::shared_ptr<TransformedPrimitive>> m_Instances;
         std::shared_ptr<Primitive> m_AggregatePrimitive;
         std::vector<std::shared_ptr<Light>> m_Lights;
 
@@ -0,0 +1,92 @@
+#include "Scene.hpp"
+
+namespace Silmaril {
+
+    Scene::Scene(std::shared_ptr<Primitive> aggregate, const std::vector<std::shared_ptr<Light>>& lights, LightSampling lightSampling)
+        : m_Aggregate(aggregate), m_Lights(lights), m_LightSampling(lightSampling)
+    {
+        if (m_Aggregate) m_GlobalBound = m_Aggregate->GetBound();
+
+        // Lights at infinity know their power only once they know how large the scene is
+        for (const auto& light : m_Lights) {
+            light->Preprocess(m_GlobalBound);
+        }
+
+        std::vector<f32> power;
+        power.reserve(m_Lights.size());
+
+        std::vector<std::pair<const Light*, LightBounds>> bounded;
+
+        for (u32 i = 0; i < m_Lights.size(); ++i) {
+            const Light* light = m_Lights[i].get();
+
+            glm::vec3 phi = light->Phi();
+            power.push_back((phi.r + phi.g + phi.b) / 3.0f);
+
+            m_LightIndices[light] = i;
+
+            if (auto bounds = light->Bounds()) {
+                bounded.emplace_back(light, *bounds);
+            } else {
+                m_InfiniteLights.push_back(light);
+            }
+        }
+
+        m_LightDistribution = AliasTable(power);
+
+        if (m_LightSampling == LightSampling::BVH) {
+            m_LightBVH = LightBVH(bounded);
+
+            f32 infinite = static_cast<f32>(m_InfiniteLights.size());
+            f32 total = infinite + (m_LightBVH.IsEmpty() ? 0.0f : 1.0f);
+            m_InfiniteProbability = total > 0.0f ? infinite / total : 0.0f;
+        }
+    }
+
+    const Light* Scene::SampleLight(const glm::vec3& p, const glm::vec3& n, f32 u, f32& pmf) const
+    {
+        pmf = 0.0f;
+        if (m_Lights.empty()) return nullptr;
+
+        if (m_LightSampling == LightSampling::Power) {
+            return m_Lights[m_LightDistribution.Sample(u, pmf)].get();
+        }
+
+        if (u < m_InfiniteProbability) {
+            u32 count = static_cast<u32>(m_InfiniteLights.size());
+            u32 index = std::min(static_cast<u32>(u / m_InfiniteProbability * count), count - 1);
+
+            pmf = m_InfiniteProbability / count;
+            return m_InfiniteLights[index];
+        }
+
+        u = std::min((u - m_InfiniteProbability) / (1.0f - m_InfiniteProbability), 0x1.fffffep-1f);
+
+        const Light* light = m_LightBVH.Sample(p, n, u, pmf);
+        pmf *= 1.0f - m_InfiniteProbability;
+
+        return light;
+    }
+
+    f32 Scene::LightPMF(const glm::vec3& p, const glm::vec3& n, const Light* light) const
+    {
+        auto it = m_LightIndices.find(light);
+        if (it == m_LightIndices.end()) return 0.0f;
+
+        if (m_LightSampling == LightSampling::Power) {
+            return m_LightDistribution.PMF(it->second);
+        }
+
+        if (!m_LightBVH.IsEmpty() && m_InfiniteProbability < 1.0f) {
+            f32 pmf = m_LightBVH.PMF(p, n, light);
+            if (pmf > 0.0f) return pmf * (1.0f - m_InfiniteProbability);
+        }
+
+        if (std::ranges::find(m_InfiniteLights, light) != m_InfiniteLights.end()) {
+            return m_InfiniteProbability / m_InfiniteLights.size();
+        }
+
+        return 0.0f;
+    }
+
+}
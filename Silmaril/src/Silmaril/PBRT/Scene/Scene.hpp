@@ -2,22 +2,38 @@
 
 #include "Silmaril/PBRT/Geometry/Primitive.hpp"
 #include "Silmaril/PBRT/Lights/Light.hpp"
+#include "Silmaril/PBRT/Lights/LightBVH.hpp"
 #include "Silmaril/PBRT/Containers/Interaction.hpp"
 #include "Silmaril/PBRT/Containers/AABB.hpp"
+#include "Silmaril/DSA/AliasTable.hpp"
 
 namespace Silmaril {
 
     class Scene
     {
     public:
-        Scene(std::shared_ptr<Primitive> aggregate, const std::vector<std::shared_ptr<Light>>& lights)
-            : m_Aggregate(aggregate), m_Lights(lights)
+        enum class LightSampling : u8
         {
-        }
+            // In proportion to emitted power, the same everywhere in the scene
+            Power,
+            // By importance at the shading point through a light BVH, lights at infinity uniformly beside it
+            BVH
+        };
 
+    public:
+        Scene(std::shared_ptr<Primitive> aggregate, const std::vector<std::shared_ptr<Light>>& lights, LightSampling lightSampling = LightSampling::BVH);
         ~Scene() = default;
 
         inline const std::vector<std::shared_ptr<Light>>& GetLights() const { return m_Lights; }
+        inline const LightBVH& GetLightBVH() const { return m_LightBVH; }
+        // Lights without bounds, their radiance reaches every ray that leaves the scene
+        inline const std::vector<const Light*>& GetInfiniteLights() const { return m_InfiniteLights; }
+
+        // Picks a light for next event estimation from the shading point p with shading normal n
+        const Light* SampleLight(const glm::vec3& p, const glm::vec3& n, f32 u, f32& pmf) const;
+
+        // Probability SampleLight picks the light from p and n, for the MIS weight of a path that hits it
+        f32 LightPMF(const glm::vec3& p, const glm::vec3& n, const Light* light) const;
         inline const AABB& GetBound() const { return m_GlobalBound; }
 
         inline bool Intersect(const Ray& ray, SurfaceInteraction& intersect) const
@@ -33,18 +49,35 @@ namespace Silmaril {
             return false;
         }
 
-        inline bool IntersectP(const Ray& ray) const
+        // Closest hit only, the caller fills the surface through hit.primitive when it needs it
+        inline bool Intersect(const Ray& ray, HitInteraction& hit) const
         {
             if (!m_Aggregate) return false;
 
-            HitInteraction hit;
             return m_Aggregate->Intersect(ray, hit);
         }
 
+        inline bool IntersectP(const Ray& ray, f32 tMax = std::numeric_limits<f32>::max()) const
+        {
+            if (!m_Aggregate) return false;
+
+            return m_Aggregate->IntersectP(ray, tMax);
+        }
+
     private:
         std::shared_ptr<Primitive> m_Aggregate;
         std::vector<std::shared_ptr<Light>> m_Lights;
 
+        LightSampling m_LightSampling;
+
+        AliasTable m_LightDistribution;
+        std::unordered_map<const Light*, u32> m_LightIndices;
+
+        LightBVH m_LightBVH;
+        std::vector<const Light*> m_InfiniteLights;
+        // Chance of sampling a light at infinity instead of walking the light BVH
+        f32 m_InfiniteProbability { 0.0f };
+
         AABB m_GlobalBound;
     };
 
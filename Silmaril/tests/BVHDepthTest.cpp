@@ -0,0 +1,129 @@
+#include "Silmaril/Core/Logger.hpp"
+#include "Silmaril/Core/JobSystem.hpp"
+#include "Silmaril/DSA/PCG32.hpp"
+#include "Silmaril/PBRT/Geometry/BVH.hpp"
+#include "Silmaril/PBRT/Geometry/Triangle.hpp"
+#include "Silmaril/PBRT/Geometry/TriangleMesh.hpp"
+#include "Silmaril/PBRT/Materials/MatteMaterial.hpp"
+
+// Builds hierarchies over inputs that nest far deeper than BVH::s_MaxDepth without the depth cap and checks that
+// every builder and layout still finds the same closest hits as testing each triangle
+
+using namespace Silmaril;
+
+namespace {
+
+    constexpr u32 s_Rays = 2000;
+
+    void AddTriangle(Mesh& mesh, std::vector<f32>& sizes, const glm::vec3& corner, f32 size)
+    {
+        u32 base = static_cast<u32>(mesh.p.size());
+        mesh.p.push_back(corner);
+        mesh.p.push_back(corner + glm::vec3(size, 0.0f, 0.0f));
+        mesh.p.push_back(corner + glm::vec3(0.0f, size, 0.5f * size));
+        mesh.indices.insert(mesh.indices.end(), { base, base + 1, base + 2 });
+        sizes.push_back(size);
+    }
+
+    // Every triangle halves the distance to the origin, each binned split peels off one of them
+    std::shared_ptr<Mesh> GeometricChain(std::vector<f32>& sizes)
+    {
+        auto mesh = std::make_shared<Mesh>();
+        for (i32 i = 0; i < 120; ++i) {
+            f32 x = std::ldexp(1.0f, -i);
+            AddTriangle(*mesh, sizes, glm::vec3(x, 0.0f, 0.0f), 0.1f * x);
+        }
+        return mesh;
+    }
+
+    // One triangle per bit of a 63-bit Morton code plus a pile of duplicates, Karras splits nest once per bit
+    std::shared_ptr<Mesh> MortonChain(std::vector<f32>& sizes)
+    {
+        auto mesh = std::make_shared<Mesh>();
+        AddTriangle(*mesh, sizes, glm::vec3(2097.151f), 0.5e-3f);
+        for (u32 bit = 0; bit < 63; ++bit) {
+            glm::vec3 corner(0.0f);
+            corner[2 - bit % 3] = static_cast<f32>(1u << (bit / 3)) * 1e-3f;
+            AddTriangle(*mesh, sizes, corner, 0.25e-3f);
+        }
+        for (u32 i = 0; i < 2000; ++i) {
+            AddTriangle(*mesh, sizes, glm::vec3(0.0f), 0.1e-3f);
+        }
+        return mesh;
+    }
+
+    u32 CountMismatches(const std::shared_ptr<Mesh>& mesh, const std::vector<f32>& sizes, const BVH::Config& config)
+    {
+        auto material = std::make_shared<MatteMaterial>(glm::vec3(0.5f));
+        auto triangleMesh = std::make_shared<TriangleMesh>(mesh, std::vector<std::shared_ptr<Material>>{}, std::vector<glm::vec3>{}, material);
+        std::shared_ptr<Primitive> bvh = BVH::Create(std::vector<std::shared_ptr<TriangleMesh>>{ triangleMesh }, config);
+
+        u32 nTriangles = static_cast<u32>(mesh->indices.size() / 3);
+        u32 mismatches = 0;
+
+        PCG32 rng;
+        rng.Seed(1, 1);
+        for (u32 r = 0; r < s_Rays; ++r) {
+            u32 triangle = rng.Next() % nTriangles;
+            TrianglePositions p = Triangle::GetPositions(*mesh, triangle);
+            glm::vec3 target = (p[0] + p[1] + p[2]) / 3.0f;
+
+            // Offsets scale with the triangle so rays stay well resolved at every level of the chain
+            glm::vec3 origin = target + sizes[triangle] * glm::vec3(0.01f, 0.02f, 1.0f + rng.Float32());
+            Ray ray(origin, target - origin);
+
+            HitInteraction hit;
+            bool found = bvh->Intersect(ray, hit);
+
+            HitInteraction expected;
+            bool expectedFound = false;
+            for (u32 i = 0; i < nTriangles; ++i) {
+                expectedFound |= Triangle::Intersect(*mesh, i, ray, expected);
+            }
+
+            if (found != expectedFound || (found && std::abs(hit.t - expected.t) > 1e-4f)) {
+                mismatches++;
+            }
+        }
+
+        return mismatches;
+    }
+
+}
+
+int main()
+{
+    Logger::Init();
+    JobSystem::Init(4);
+
+    std::vector<f32> geometricSizes;
+    std::vector<f32> mortonSizes;
+    std::shared_ptr<Mesh> geometric = GeometricChain(geometricSizes);
+    std::shared_ptr<Mesh> morton = MortonChain(mortonSizes);
+
+    u32 failures = 0;
+
+    for (BVH::Strategy strategy : { BVH::Strategy::SAH, BVH::Strategy::SBVH, BVH::Strategy::LBVH }) {
+        for (BVH::Layout layout : { BVH::Layout::Binary, BVH::Layout::Wide8, BVH::Layout::Compressed8 }) {
+            BVH::Config config;
+            config.maxPrimitivesInLeaf = 1;
+            config.layout = layout;
+            config.strategy = strategy;
+            config.mortonBits = 63;
+
+            bool lbvh = strategy == BVH::Strategy::LBVH;
+            u32 mismatches = lbvh ? CountMismatches(morton, mortonSizes, config) : CountMismatches(geometric, geometricSizes, config);
+
+            if (mismatches > 0) {
+                LOG_ERROR("Strategy {} layout {}: {} of {} rays disagree with testing every triangle",
+                    static_cast<u32>(strategy), static_cast<u32>(layout), mismatches, s_Rays);
+                failures++;
+            }
+        }
+    }
+
+    JobSystem::Shutdown();
+    Logger::Shutdown();
+
+    return failures == 0 ? 0 : 1;
+}